@@ -0,0 +1,116 @@
+#include <cstdint>
+#include <new>
+#include <omp.h>
+#include "inc/main.hxx"
+#include "inc/gvelouvain.h"
+
+using namespace std;
+
+
+
+
+#pragma region METHODS
+#pragma region HELPERS
+/**
+ * Convert C API options into Louvain options.
+ * @param x C API options, or null for defaults
+ * @returns louvain options
+ */
+inline LouvainOptions gveLouvainOptions(const gve_louvain_options *x) {
+  if (!x) return LouvainOptions();
+  return LouvainOptions(x->repeat, x->resolution, x->tolerance, x->aggregation_tolerance, x->tolerance_drop, x->max_iterations, x->max_passes);
+}
+
+
+/**
+ * Check if C API options are valid.
+ * @param x C API options, or null for defaults
+ * @returns are options valid?
+ */
+inline bool gveLouvainOptionsValid(const gve_louvain_options *x) {
+  if (!x) return true;
+  return x->repeat>0 && x->max_iterations>0 && x->max_passes>0 && x->resolution>0
+      && x->tolerance>=0 && x->aggregation_tolerance>0 && x->tolerance_drop>0;
+}
+
+
+/**
+ * Check if a CSR graph passed through the C API is well-formed.
+ * @param n number of vertices
+ * @param offsets offsets of the outgoing edges of each vertex (size n+1)
+ * @param edges target vertex ids of the outgoing edges (size offsets[n])
+ * @returns are offsets non-decreasing from zero, and all target ids less than n?
+ */
+inline bool gveLouvainGraphValid(uint32_t n, const uint64_t *offsets, const uint32_t *edges) {
+  size_t bad = offsets[0]!=0;
+  #pragma omp parallel for schedule(dynamic, 2048) reduction(+:bad)
+  for (uint32_t u=0; u<n; ++u) {
+    uint64_t i = offsets[u], I = offsets[u+1];
+    if (i>I) { ++bad; continue; }
+    for (; i<I; ++i)
+      bad += edges[i]>=n;
+  }
+  return bad==0;
+}
+#pragma endregion
+
+
+
+
+#pragma region C API
+extern "C" {
+int gve_louvain_api_version(void) {
+  return GVE_LOUVAIN_API_VERSION;
+}
+
+
+void gve_louvain_default_options(gve_louvain_options *o) {
+  if (!o) return;
+  LouvainOptions d;
+  o->repeat         = d.repeat;
+  o->max_iterations = d.maxIterations;
+  o->max_passes     = d.maxPasses;
+  o->padding        = 0;
+  o->resolution     = d.resolution;
+  o->tolerance      = d.tolerance;
+  o->aggregation_tolerance = d.aggregationTolerance;
+  o->tolerance_drop = d.toleranceDrop;
+}
+
+
+int gve_louvain_static(
+  uint32_t n, const uint64_t *offsets, const uint32_t *edges, const float *weights,
+  const gve_louvain_options *o, int threads, uint32_t *membership, gve_louvain_stats *stats) {
+  if (!offsets || !membership || (offsets[n]>0 && !edges) || threads<0) return GVE_LOUVAIN_EINVAL;
+  if (!gveLouvainOptionsValid(o)) return GVE_LOUVAIN_EINVAL;
+  using K = uint32_t;
+  using O = uint64_t;
+  DiGraphCsrView<K, None, float, O> x(n, offsets, edges, weights);
+  int T = omp_get_max_threads();
+  if (threads>0) omp_set_num_threads(threads);
+  int status = GVE_LOUVAIN_OK;
+  try {
+    if (!gveLouvainGraphValid(n, offsets, edges)) status = GVE_LOUVAIN_EINVAL;
+    else {
+      auto a = louvainStaticOmpW(membership, x, gveLouvainOptions(o));
+      if (stats) {
+        auto   fc = [&](auto u) { return membership[u]; };
+        double M  = edgeWeightOmp(x)/2;
+        stats->iterations       = a.iterations;
+        stats->passes           = a.passes;
+        stats->time             = a.time;
+        stats->local_move_time  = a.localMoveTime;
+        stats->aggregation_time = a.aggregationTime;
+        stats->padding          = 0;
+        stats->modularity       = modularityByOmp(x, fc, M, o? o->resolution : 1.0);
+      }
+    }
+  }
+  catch (const bad_alloc&) { status = GVE_LOUVAIN_ENOMEM; }
+  catch (...)              { status = GVE_LOUVAIN_EINTERNAL; }
+  if (threads>0) omp_set_num_threads(T);
+  return status;
+}
+}
+#pragma endregion
+#pragma endregion
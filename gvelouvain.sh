@@ -0,0 +1,9 @@
+#!/usr/bin/env bash
+# Build the C API shared library (see inc/gvelouvain.h)
+out="${1:-libgvelouvain.so}"
+
+# Fixed config
+: "${CXX:=g++}"
+
+# Build
+$CXX -std=c++17 -O3 -fopenmp -fPIC -shared gvelouvain.cxx -o "$out"
@@ -1,14 +1,22 @@
 #pragma once
 #include <utility>
+#include <type_traits>
 #include <vector>
 #include <ostream>
 #include <algorithm>
 #include "_main.hxx"
 
 using std::pair;
+using std::make_pair;
 using std::vector;
 using std::ostream;
 using std::max;
+using std::copy;
+using std::move;
+using std::sort;
+using std::lower_bound;
+using std::true_type;
+using std::false_type;
 
 
 
@@ -168,6 +176,16 @@ class DiGraph {
     return u < span()? edges[u].size() : 0;
   }
 
+  /**
+   * Get an outgoing edge of a vertex in the graph, by its position.
+   * @param u vertex id
+   * @param i edge index (< degree(u))
+   * @returns [target vertex id, edge weight]
+   */
+  inline pair<K, E> edgeAt(K u, size_t i) const noexcept {
+    return edges[u].at(i);
+  }
+
   /**
    * Get the vertex data of a vertex in the graph.
    * @param u vertex id
@@ -270,6 +288,30 @@ class DiGraph {
     if (u < span()) edges[u].update(buf);
   }
 
+  /**
+   * Remove and add outgoing edges of a vertex in a single merge pass.
+   * @param u source vertex id
+   * @param dels target vertex ids of edges to remove (sorted)
+   * @param nd number of edges to remove
+   * @param ins target vertex ids and weights of edges to add (sorted, unique)
+   * @param ni number of edges to add
+   * @note Target vertices must exist. Use adjustSize() to account for the
+   * change in number of edges.
+   */
+  inline void mergeEdges(K u, const K *dels, size_t nd, const pair<K, E> *ins, size_t ni) {
+    if (u < span()) edges[u].merge(dels, nd, ins, ni);
+  }
+
+  /**
+   * Account for vertices and edges changed without a full update().
+   * @param dn change in number of vertices
+   * @param dm change in number of edges
+   */
+  inline void adjustSize(ssize_t dn, ssize_t dm) noexcept {
+    N += dn;
+    M += dm;
+  }
+
   /**
    * Update the graph to reflect the changes.
    * @note This is an expensive operation.
@@ -374,14 +416,16 @@ class DiGraph {
 
 
 /**
- * A directed graph with CSR representation.
+ * Directed graph that memorizes only out-edges for each vertex, with edges
+ * stored in a shared slab arena (instead of a vector per vertex).
  * @tparam K key type (vertex id)
  * @tparam V vertex value type (vertex data)
  * @tparam E edge value type (edge weight)
- * @tparam O offset type
+ * @note Edges of each vertex are kept in a power-of-two sized block, which is
+ * relocated to a larger block when it fills up.
  */
-template <class K=uint32_t, class V=None, class E=None, class O=size_t>
-class DiGraphCsr {
+template <class K=uint32_t, class V=None, class E=None>
+class DiGraphArena {
   #pragma region TYPES
   public:
   /** Key type (vertex id). */
@@ -390,21 +434,36 @@ class DiGraphCsr {
   using vertex_value_type = V;
   /** Edge value type (edge weight). */
   using edge_value_type   = E;
+
+  protected:
+  /** Outgoing edges of a vertex, in an arena block. */
+  struct Row {
+    /** Edges (sorted, followed by unprocessed insertions/deletions). */
+    pair<K, E> *data = nullptr;
+    /** Number of entries in the block. */
+    uint32_t size = 0;
+    /** Number of unprocessed insertions and deletions (-ve). */
+    int32_t unprocessed = 0;
+    /** Size class of the block. */
+    uint8_t sizeClass = 0;
+  };
   #pragma endregion
 
 
   #pragma region DATA
-  public:
-  /** Offsets of the outgoing edges of vertices. */
-  vector<O> offsets;
-  /** Degree of each vertex. */
-  vector<K> degrees;
+  protected:
+  /** Number of vertices. */
+  size_t N = 0;
+  /** Number of edges. */
+  size_t M = 0;
+  /** Vertex existence flags. */
+  vector<bool> exists;
   /** Vertex values. */
   vector<V> values;
-  /** Vertex ids of the outgoing edges of each vertex (lookup using offsets). */
-  vector<K> edgeKeys;
-  /** Edge weights of the outgoing edges of each vertex (lookup using offsets). */
-  vector<E> edgeValues;
+  /** Outgoing edges for each vertex (including edge weights). */
+  vector<Row> edges;
+  /** Arena holding the edges of all vertices. */
+  SlabArena<pair<K, E>> arena;
   #pragma endregion
 
 
@@ -417,7 +476,7 @@ class DiGraphCsr {
    * @returns size of buffer required
    */
   inline size_t span() const noexcept {
-    return degrees.size();
+    return exists.size();
   }
 
   /**
@@ -425,17 +484,14 @@ class DiGraphCsr {
    * @returns |V|
    */
   inline size_t order() const noexcept {
-    return degrees.size();
+    return N;
   }
 
   /**
-   * Obtain the number of edges in the graph.
+   * Get the number of edges in the graph.
    * @returns |E|
    */
   inline size_t size() const noexcept {
-    size_t M = 0;
-    for (auto d : degrees)
-      M += d;
     return M;
   }
 
@@ -444,7 +500,7 @@ class DiGraphCsr {
    * @returns is the graph empty?
    */
   inline bool empty() const noexcept {
-    return degrees.empty();
+    return N == 0;
   }
 
   /**
@@ -454,6 +510,14 @@ class DiGraphCsr {
   inline bool directed() const noexcept {
     return true;
   }
+
+  /**
+   * Get the number of edge slots held by the arena.
+   * @returns capacity of the arena
+   */
+  inline size_t capacity() const noexcept {
+    return arena.capacity();
+  }
   #pragma endregion
 
 
@@ -466,7 +530,7 @@ class DiGraphCsr {
   template <class FP>
   inline void forEachVertex(FP fp) const noexcept {
     for (K u=0; u<span(); ++u)
-      fp(u, values[u]);
+      if (exists[u]) fp(u, values[u]);
   }
 
   /**
@@ -476,7 +540,7 @@ class DiGraphCsr {
   template <class FP>
   inline void forEachVertexKey(FP fp) const noexcept {
     for (K u=0; u<span(); ++u)
-      fp(u);
+      if (exists[u]) fp(u);
   }
 
   /**
@@ -486,10 +550,10 @@ class DiGraphCsr {
    */
   template <class FP>
   inline void forEachEdge(K u, FP fp) const noexcept {
-    size_t i = offsets[u];
-    size_t d = degrees[u];
-    for (size_t I=i+d; i<I; ++i)
-      fp(edgeKeys[i], edgeValues[i]);
+    if (u >= span()) return;
+    const Row& r = edges[u];
+    for (uint32_t i=0; i<r.size; ++i)
+      fp(r.data[i].first, r.data[i].second);
   }
 
   /**
@@ -499,30 +563,102 @@ class DiGraphCsr {
    */
   template <class FP>
   inline void forEachEdgeKey(K u, FP fp) const noexcept {
-    size_t i = offsets[u];
-    size_t d = degrees[u];
-    for (size_t I=i+d; i<I; ++i)
-      fp(edgeKeys[i]);
+    if (u >= span()) return;
+    const Row& r = edges[u];
+    for (uint32_t i=0; i<r.size; ++i)
+      fp(r.data[i].first);
   }
   #pragma endregion
 
 
-  #pragma region OFFSET
-  public:
+  #pragma region ROW
+  protected:
   /**
-   * Get the offset of an edge in the graph.
-   * @param u source vertex id
+   * Find the edge to a target vertex, among processed edges of a row.
+   * @param r row
    * @param v target vertex id
-   * @returns offset of the edge, or -1 if it does not exist
+   * @returns pointer to edge, or null if not found
    */
-  inline size_t edgeOffset(K u, K v) const noexcept {
-    if (!hasVertex(u) || !hasVertex(v)) return size_t(-1);
-    size_t  i = offsets[u];
-    size_t  d = degrees[u];
-    auto   ib = edgeKeys.begin() + i;
-    auto   ie = edgeKeys.begin() + i + d;
-    auto   it = find(ib, ie, v);
-    return it!=ie? it - edgeKeys.begin() : size_t(-1);
+  static inline pair<K, E>* findEdge(const Row& r, K v) noexcept {
+    auto fl = [](const auto& p, K k) { return p.first < k; };
+    auto ie = r.data + r.size;
+    auto it = lower_bound(r.data, ie, v, fl);
+    return it==ie || (*it).first!=v? nullptr : it;
+  }
+
+  /**
+   * Ensure that a row has space for a number of entries.
+   * @param r row (updated)
+   * @param n number of entries
+   * @note The row is relocated to a larger block if needed.
+   */
+  inline void reserveRow(Row& r, size_t n) {
+    if (r.data && n <= arena.classCapacity(r.sizeClass)) return;
+    uint8_t c = arena.sizeClass(n);
+    auto   *p = arena.allocate(c);
+    copy(r.data, r.data + r.size, p);
+    arena.free(r.data, r.sizeClass);
+    r.data = p;
+    r.sizeClass = c;
+  }
+
+  /**
+   * Release the block of a row.
+   * @param r row (updated)
+   */
+  inline void clearRow(Row& r) {
+    arena.free(r.data, r.sizeClass);
+    r = Row();
+  }
+
+  /**
+   * Sort out all unprocessed deletions of a row.
+   * @param r row (updated)
+   */
+  inline void updateRowRemove(Row& r) {
+    auto fl = [](const auto& p, const auto& q) { return p.first <  q.first; };
+    auto fe = [](const auto& p, const auto& q) { return p.first == q.first; };
+    auto ib = r.data;
+    auto ie = r.data + r.size;
+    auto im = ie + r.unprocessed;
+    sort(im, ie, fl);
+    auto it = set_difference_inplace(ib, im, im, ie, fl, fe);
+    r.size = uint32_t(it - ib);
+    r.unprocessed = 0;
+  }
+
+  /**
+   * Sort out all unprocessed insertions of a row.
+   * @param r row (updated)
+   * @param buf scratch buffer for the update
+   */
+  inline void updateRowAdd(Row& r, vector<pair<K, E>> *buf=nullptr) {
+    auto fl = [](const auto& p, const auto& q) { return p.first <  q.first; };
+    auto fe = [](const auto& p, const auto& q) { return p.first == q.first; };
+    size_t N = r.size;
+    size_t need = r.unprocessed + 4;
+    if (!buf) reserveRow(r, N + need);
+    else if (buf->size() < need) buf->resize(need);
+    auto bb = buf? buf->data() : r.data + N;
+    auto be = bb + need;
+    auto ib = r.data;
+    auto ie = r.data + N;
+    auto im = ie - r.unprocessed;
+    sort(im, ie, fl);
+    auto it = set_union_last_inplace(ib, im, im, ie, bb, be, fl, fe);
+    r.size = uint32_t(it - ib);
+    r.unprocessed = 0;
+  }
+
+  /**
+   * Sort out all unprocessed insertions and deletions of a row.
+   * @param r row (updated)
+   * @param buf scratch buffer for the update
+   */
+  inline void updateRow(Row& r, vector<pair<K, E>> *buf=nullptr) {
+    if (r.unprocessed == 0) return;
+    if (r.unprocessed  < 0) updateRowRemove(r);
+    else updateRowAdd(r, buf);
   }
   #pragma endregion
 
@@ -535,7 +671,7 @@ class DiGraphCsr {
    * @returns does the vertex exist?
    */
   inline bool hasVertex(K u) const noexcept {
-    return u < span();
+    return u < span() && exists[u];
   }
 
   /**
@@ -545,8 +681,7 @@ class DiGraphCsr {
    * @returns does the edge exist?
    */
   inline bool hasEdge(K u, K v) const noexcept {
-    size_t o = edgeOffset(u, v);
-    return o != size_t(-1);
+    return u < span() && findEdge(edges[u], v);
   }
 
   /**
@@ -555,7 +690,17 @@ class DiGraphCsr {
    * @returns number of outgoing edges of the vertex
    */
   inline size_t degree(K u) const noexcept {
-    return u < span()? degrees[u] : 0;
+    return u < span()? edges[u].size : 0;
+  }
+
+  /**
+   * Get an outgoing edge of a vertex in the graph, by its position.
+   * @param u vertex id
+   * @param i edge index (< degree(u))
+   * @returns [target vertex id, edge weight]
+   */
+  inline pair<K, E> edgeAt(K u, size_t i) const noexcept {
+    return edges[u].data[i];
   }
 
   /**
@@ -586,8 +731,8 @@ class DiGraphCsr {
    * @returns associated weight of the edge
    */
   inline E edgeValue(K u, K v) const noexcept {
-    size_t o = edgeOffset(u, v);
-    return o != size_t(-1)? edgeValues[o] : E();
+    auto  *p = u < span()? findEdge(edges[u], v) : nullptr;
+    return p? p->second : E();
   }
 
   /**
@@ -598,9 +743,10 @@ class DiGraphCsr {
    * @returns success?
    */
   inline bool setEdgeValue(K u, K v, E w) noexcept {
-    size_t o = edgeOffset(u, v);
-    if (o == size_t(-1)) return false;
-    edgeValues[o] = w;
+    if (!hasVertex(u) || !hasVertex(v)) return false;
+    auto *p = findEdge(edges[u], v);
+    if (!p) return false;
+    p->second = w;
     return true;
   }
   #pragma endregion
@@ -609,72 +755,901 @@ class DiGraphCsr {
   #pragma region UPDATE
   public:
   /**
-   * Adjust the span of the graph (or the number of vertices).
+   * Remove all vertices and edges from the graph.
+   */
+  inline void clear() {
+    N = 0; M = 0;
+    exists.clear();
+    values.clear();
+    edges.clear();
+    arena.clear();
+  }
+
+  /**
+   * Reserve space for outgoing edges of a vertex in the graph.
+   * @param u source vertex id
+   * @param deg expected degree of the vertex
+   */
+  inline void reserveEdges(K u, size_t deg) {
+    if (u < span()) reserveRow(edges[u], deg);
+  }
+
+  /**
+   * Reserve space for a number of vertices and edges in the graph.
+   * @param n number of vertices to reserve space for
+   * @param deg expected average degree of vertices
+   */
+  inline void reserve(size_t n, size_t deg=0) {
+    size_t S = max(n, span());
+    respan(S);
+    if (deg==0) return;
+    for (K u=0; u<S; ++u)
+      reserveRow(edges[u], deg);
+  }
+
+  /**
+   * Adjust the span of the graph.
    * @param n new span
+   * @note This operation is lazy.
    */
   inline void respan(size_t n) {
-    offsets.resize(n+1);
-    degrees.resize(n);
+    #ifdef OPENMP
+    arena.reserveThreads(omp_get_max_threads());
+    #endif
+    for (size_t u=n; u<span(); ++u)
+      clearRow(edges[u]);
+    exists.resize(n);
     values.resize(n);
+    edges.resize(n);
   }
-  #pragma endregion
-  #pragma endregion
 
+  /**
+   * Update the outgoing edges of a vertex in the graph to reflect the changes.
+   * @param u source vertex id
+   * @param buf scratch buffer for the update
+   */
+  inline void updateEdges(K u, vector<pair<K, E>> *buf=nullptr) {
+    if (u < span()) updateRow(edges[u], buf);
+  }
 
-  #pragma region CONSTRUCTORS
-  public:
   /**
-   * Allocate space for CSR representation of a directed graph.
-   * @param n number of vertices
-   * @param m number of edges
+   * Remove and add outgoing edges of a vertex in a single merge pass.
+   * @param u source vertex id
+   * @param dels target vertex ids of edges to remove (sorted)
+   * @param nd number of edges to remove
+   * @param ins target vertex ids and weights of edges to add (sorted, unique)
+   * @param ni number of edges to add
+   * @note Target vertices must exist. Use adjustSize() to account for the
+   * change in number of edges.
    */
-  DiGraphCsr(size_t n, size_t m) {
-    offsets.resize(n+1);
-    degrees.resize(n);
-    values.resize(n);
-    edgeKeys.resize(m);
-    edgeValues.resize(m);
+  inline void mergeEdges(K u, const K *dels, size_t nd, const pair<K, E> *ins, size_t ni) {
+    if (u >= span()) return;
+    Row& r = edges[u];
+    updateRow(r);
+    reserveRow(r, r.size + ni);
+    auto  *a = r.data;
+    ssize_t i = ssize_t(r.size) - 1;
+    ssize_t j = ssize_t(ni) - 1;
+    ssize_t d = ssize_t(nd) - 1;
+    size_t  k = r.size + ni;
+    // Merge from the back, so that no entry is overwritten before it is read.
+    while (i>=0 || j>=0) {
+      if (j<0 || (i>=0 && a[i].first > ins[j].first)) {
+        K key = a[i].first;
+        while (d>=0 && dels[d] > key) --d;
+        if (d<0 || dels[d]!=key) a[--k] = a[i];
+        --i;
+      }
+      else {
+        if (i>=0 && a[i].first == ins[j].first) --i;
+        a[--k] = ins[j--];
+      }
+    }
+    r.size = uint32_t(copy(a + k, a + r.size + ni, a) - a);
   }
-  #pragma endregion
-};
-#pragma endregion
 
+  /**
+   * Account for vertices and edges changed without a full update().
+   * @param dn change in number of vertices
+   * @param dm change in number of edges
+   */
+  inline void adjustSize(ssize_t dn, ssize_t dm) noexcept {
+    N += dn;
+    M += dm;
+  }
 
+  /**
+   * Update the graph to reflect the changes.
+   * @note This is an expensive operation.
+   */
+  inline void update() {
+    vector<pair<K, E>> buf;
+    N = 0; M = 0;
+    forEachVertexKey([&](K u) {
+      updateRow(edges[u], &buf);
+      M += degree(u); ++N;
+    });
+  }
 
+  /**
+   * Add a vertex to the graph.
+   * @param u vertex id
+   * @note This operation is lazy.
+   */
+  inline void addVertex(K u) {
+    if (hasVertex(u)) return;
+    if (u >= span()) respan(u+1);
+    exists[u] = true;
+  }
 
-#pragma region METHODS
-#pragma region WRITE
-/**
- * Write the only the sizes of a graph to an output stream.
- * @tparam G graph type
- * @param a output stream
- * @param x graph
- */
-template <class G>
-inline void writeGraphSizes(ostream& a, const G& x) {
-  a << "order: " << x.order() << " size: " << x.size();
-  a << (x.directed()? " [directed]" : " [undirected]") << " {}";
-}
+  /**
+   * Add a vertex to the graph.
+   * @param u vertex id
+   * @param d associated data of the vertex
+   * @note This operation is lazy.
+   */
+  inline void addVertex(K u, V d) {
+    if (hasVertex(u)) { values[u] = d; return; }
+    if (u >= span()) respan(u+1);
+    exists[u] = true;
+    values[u] = d;
+  }
 
-/**
- * @brief Write the full details of a graph to an output stream.
- * @tparam G graph type
- * @param a output stream
- * @param x graph
- */
-template <class G>
-inline void writeGraphDetailed(ostream& a, const G& x) {
-  a << "order: " << x.order() << " size: " << x.size();
-  a << (x.directed()? " [directed]" : " [undirected]") << " {\n";
-  x.forEachVertex([&](auto u, auto d) {
-    a << u << ":" << d << " ->";
-    x.forEachEdge(u, [&](auto v, auto w) {
-      a << " " << v << ":" << w;
-    });
-    a << "\n";
-  });
-  a << "}";
-}
+  /**
+   * Add an outgoing edge to the graph if a condition is met.
+   * @param u source vertex id
+   * @param v target vertex id
+   * @param w associated weight of the edge
+   * @param ft test function (source vertex id)
+   */
+  template <class FT>
+  inline void addEdgeIf(K u, K v, E w, FT ft) {
+    addVertex(u);
+    addVertex(v);
+    if (!ft(u)) return;
+    Row& r = edges[u];
+    if (r.unprocessed < 0) updateRowRemove(r);
+    reserveRow(r, r.size + 1);
+    r.data[r.size++] = {v, w};
+    ++r.unprocessed;
+  }
+
+  /**
+   * Add an outgoing edge to the graph.
+   * @param u source vertex id
+   * @param v target vertex id
+   * @param w associated weight of the edge
+   * @note This operation is lazy.
+   */
+  inline void addEdge(K u, K v, E w=E()) {
+    auto ft = [](K u) { return true; };
+    addEdgeIf(u, v, w, ft);
+  }
+
+  /**
+   * Remove an outgoing edge from the graph if a condition is met.
+   * @param u source vertex id
+   * @param v target vertex id
+   * @param ft test function (source vertex id)
+   */
+  template <class FT>
+  inline void removeEdgeIf(K u, K v, FT ft) {
+    if (!hasVertex(u) || !hasVertex(v)) return;
+    if (!ft(u)) return;
+    Row& r = edges[u];
+    if (r.unprocessed > 0) updateRowAdd(r);
+    reserveRow(r, r.size + 1);
+    r.data[r.size++] = {v, E()};
+    --r.unprocessed;
+  }
+
+  /**
+   * Remove an outgoing edge from the graph.
+   * @param u source vertex id
+   * @param v target vertex id
+   * @note This operation is lazy.
+   */
+  inline void removeEdge(K u, K v) {
+    auto ft = [](K u) { return true; };
+    removeEdgeIf(u, v, ft);
+  }
+
+  /**
+   * Remove a vertex from the graph.
+   * @param u vertex id
+   * @note This operation is lazy.
+   */
+  inline void removeVertex(K u) {
+    if (!hasVertex(u)) return;
+    exists[u] = false;
+    values[u] = V();
+    clearRow(edges[u]);
+  }
+  #pragma endregion
+  #pragma endregion
+
+
+  #pragma region CONSTRUCTORS
+  public:
+  /**
+   * Create an empty graph.
+   */
+  DiGraphArena() {}
+
+  /**
+   * Copy a graph, packing the edges of each vertex into the smallest block.
+   * @param x graph to copy
+   */
+  DiGraphArena(const DiGraphArena& x) :
+  N(x.N), M(x.M), exists(x.exists), values(x.values), edges(x.span()) {
+    #ifdef OPENMP
+    arena.reserveThreads(omp_get_max_threads());
+    #endif
+    for (size_t u=0; u<x.span(); ++u) {
+      const Row& r = x.edges[u];
+      if (!r.data) continue;
+      reserveRow(edges[u], r.size);
+      copy(r.data, r.data + r.size, edges[u].data);
+      edges[u].size = r.size;
+      edges[u].unprocessed = r.unprocessed;
+    }
+  }
+
+  /**
+   * Copy a graph.
+   * @param x graph to copy
+   * @returns this
+   */
+  DiGraphArena& operator=(const DiGraphArena& x) {
+    if (this != &x) { DiGraphArena a(x); *this = move(a); }
+    return *this;
+  }
+
+  DiGraphArena(DiGraphArena&&) = default;
+  DiGraphArena& operator=(DiGraphArena&&) = default;
+  #pragma endregion
+};
+
+
+
+/**
+ * A directed graph with CSR representation.
+ * @tparam K key type (vertex id)
+ * @tparam V vertex value type (vertex data)
+ * @tparam E edge value type (edge weight)
+ * @tparam O offset type
+ */
+template <class K=uint32_t, class V=None, class E=None, class O=size_t>
+class DiGraphCsr {
+  #pragma region TYPES
+  public:
+  /** Key type (vertex id). */
+  using key_type = K;
+  /** Vertex value type (vertex data). */
+  using vertex_value_type = V;
+  /** Edge value type (edge weight). */
+  using edge_value_type   = E;
+  #pragma endregion
+
+
+  #pragma region DATA
+  public:
+  /** Offsets of the outgoing edges of vertices. */
+  vector<O> offsets;
+  /** Degree of each vertex. */
+  vector<K> degrees;
+  /** Vertex values. */
+  vector<V> values;
+  /** Vertex ids of the outgoing edges of each vertex (lookup using offsets). */
+  vector<K> edgeKeys;
+  /** Edge weights of the outgoing edges of each vertex (lookup using offsets). */
+  vector<E> edgeValues;
+  #pragma endregion
+
+
+  #pragma region METHODS
+  #pragma region PROPERTIES
+  public:
+  /**
+   * Get the size of buffer required to store data associated with each vertex
+   * in the graph, indexed by its vertex-id.
+   * @returns size of buffer required
+   */
+  inline size_t span() const noexcept {
+    return degrees.size();
+  }
+
+  /**
+   * Get the number of vertices in the graph.
+   * @returns |V|
+   */
+  inline size_t order() const noexcept {
+    return degrees.size();
+  }
+
+  /**
+   * Obtain the number of edges in the graph.
+   * @returns |E|
+   */
+  inline size_t size() const noexcept {
+    size_t M = 0;
+    for (auto d : degrees)
+      M += d;
+    return M;
+  }
+
+  /**
+   * Check if the graph is empty.
+   * @returns is the graph empty?
+   */
+  inline bool empty() const noexcept {
+    return degrees.empty();
+  }
+
+  /**
+   * Check if the graph is directed.
+   * @returns is the graph directed?
+   */
+  inline bool directed() const noexcept {
+    return true;
+  }
+  #pragma endregion
+
+
+  #pragma region FOREACH
+  public:
+  /**
+   * Iterate over the vertices in the graph.
+   * @param fp process function (vertex id, vertex data)
+   */
+  template <class FP>
+  inline void forEachVertex(FP fp) const noexcept {
+    for (K u=0; u<span(); ++u)
+      fp(u, values[u]);
+  }
+
+  /**
+   * Iterate over the vertex ids in the graph.
+   * @param fp process function (vertex id)
+   */
+  template <class FP>
+  inline void forEachVertexKey(FP fp) const noexcept {
+    for (K u=0; u<span(); ++u)
+      fp(u);
+  }
+
+  /**
+   * Iterate over the outgoing edges of a source vertex in the graph.
+   * @param u source vertex id
+   * @param fp process function (target vertex id, edge weight)
+   */
+  template <class FP>
+  inline void forEachEdge(K u, FP fp) const noexcept {
+    size_t i = offsets[u];
+    size_t d = degrees[u];
+    for (size_t I=i+d; i<I; ++i)
+      fp(edgeKeys[i], edgeValues[i]);
+  }
+
+  /**
+   * Iterate over the target vertex ids of a source vertex in the graph.
+   * @param u source vertex id
+   * @param fp process function (target vertex id)
+   */
+  template <class FP>
+  inline void forEachEdgeKey(K u, FP fp) const noexcept {
+    size_t i = offsets[u];
+    size_t d = degrees[u];
+    for (size_t I=i+d; i<I; ++i)
+      fp(edgeKeys[i]);
+  }
+  #pragma endregion
+
+
+  #pragma region OFFSET
+  public:
+  /**
+   * Get the offset of an edge in the graph.
+   * @param u source vertex id
+   * @param v target vertex id
+   * @returns offset of the edge, or -1 if it does not exist
+   */
+  inline size_t edgeOffset(K u, K v) const noexcept {
+    if (!hasVertex(u) || !hasVertex(v)) return size_t(-1);
+    size_t  i = offsets[u];
+    size_t  d = degrees[u];
+    auto   ib = edgeKeys.begin() + i;
+    auto   ie = edgeKeys.begin() + i + d;
+    auto   it = find(ib, ie, v);
+    return it!=ie? it - edgeKeys.begin() : size_t(-1);
+  }
+  #pragma endregion
+
+
+  #pragma region ACCESS
+  public:
+  /**
+   * Check if a vertex exists in the graph.
+   * @param u vertex id
+   * @returns does the vertex exist?
+   */
+  inline bool hasVertex(K u) const noexcept {
+    return u < span();
+  }
+
+  /**
+   * Check if an edge exists in the graph.
+   * @param u source vertex id
+   * @param v target vertex id
+   * @returns does the edge exist?
+   */
+  inline bool hasEdge(K u, K v) const noexcept {
+    size_t o = edgeOffset(u, v);
+    return o != size_t(-1);
+  }
+
+  /**
+   * Get the number of outgoing edges of a vertex in the graph.
+   * @param u vertex id
+   * @returns number of outgoing edges of the vertex
+   */
+  inline size_t degree(K u) const noexcept {
+    return u < span()? degrees[u] : 0;
+  }
+
+  /**
+   * Get an outgoing edge of a vertex in the graph, by its position.
+   * @param u vertex id
+   * @param i edge index (< degree(u))
+   * @returns [target vertex id, edge weight]
+   */
+  inline pair<K, E> edgeAt(K u, size_t i) const noexcept {
+    size_t o = offsets[u] + i;
+    return make_pair(edgeKeys[o], edgeValues[o]);
+  }
+
+  /**
+   * Get the vertex data of a vertex in the graph.
+   * @param u vertex id
+   * @returns associated data of the vertex
+   */
+  inline V vertexValue(K u) const noexcept {
+    return u < span()? values[u] : V();
+  }
+
+  /**
+   * Set the vertex data of a vertex in the graph.
+   * @param u vertex id
+   * @param d associated data of the vertex
+   * @returns success?
+   */
+  inline bool setVertexValue(K u, V d) noexcept {
+    if (!hasVertex(u)) return false;
+    values[u] = d;
+    return true;
+  }
+
+  /**
+   * Get the edge weight of an edge in the graph.
+   * @param u source vertex id
+   * @param v target vertex id
+   * @returns associated weight of the edge
+   */
+  inline E edgeValue(K u, K v) const noexcept {
+    size_t o = edgeOffset(u, v);
+    return o != size_t(-1)? edgeValues[o] : E();
+  }
+
+  /**
+   * Set the edge weight of an edge in the graph.
+   * @param u source vertex id
+   * @param v target vertex id
+   * @param w associated weight of the edge
+   * @returns success?
+   */
+  inline bool setEdgeValue(K u, K v, E w) noexcept {
+    size_t o = edgeOffset(u, v);
+    if (o == size_t(-1)) return false;
+    edgeValues[o] = w;
+    return true;
+  }
+  #pragma endregion
+
+
+  #pragma region UPDATE
+  public:
+  /**
+   * Adjust the span of the graph (or the number of vertices).
+   * @param n new span
+   */
+  inline void respan(size_t n) {
+    offsets.resize(n+1);
+    degrees.resize(n);
+    values.resize(n);
+  }
+  #pragma endregion
+  #pragma endregion
+
+
+  #pragma region CONSTRUCTORS
+  public:
+  /**
+   * Allocate space for CSR representation of a directed graph.
+   * @param n number of vertices
+   * @param m number of edges
+   */
+  DiGraphCsr(size_t n, size_t m) {
+    offsets.resize(n+1);
+    degrees.resize(n);
+    values.resize(n);
+    edgeKeys.resize(m);
+    edgeValues.resize(m);
+  }
+  #pragma endregion
+};
+
+
+
+/**
+ * A non-owning view of a directed graph in CSR representation.
+ * @tparam K key type (vertex id)
+ * @tparam V vertex value type (vertex data)
+ * @tparam E edge value type (edge weight)
+ * @tparam O offset type
+ * @note Degrees are obtained from consecutive offsets. If edge values are not
+ * provided, each edge has a weight of 1. The viewed arrays must outlive the view.
+ */
+template <class K=uint32_t, class V=None, class E=None, class O=size_t>
+class DiGraphCsrView {
+  #pragma region TYPES
+  public:
+  /** Key type (vertex id). */
+  using key_type = K;
+  /** Vertex value type (vertex data). */
+  using vertex_value_type = V;
+  /** Edge value type (edge weight). */
+  using edge_value_type   = E;
+  #pragma endregion
+
+
+  #pragma region DATA
+  public:
+  /** Number of vertices. */
+  size_t N;
+  /** Offsets of the outgoing edges of vertices (size N+1). */
+  const O *offsets;
+  /** Vertex ids of the outgoing edges of each vertex (lookup using offsets). */
+  const K *edgeKeys;
+  /** Edge weights of the outgoing edges of each vertex, or null for unit weights. */
+  const E *edgeValues;
+  #pragma endregion
+
+
+  #pragma region METHODS
+  #pragma region PROPERTIES
+  public:
+  /**
+   * Get the size of buffer required to store data associated with each vertex
+   * in the graph, indexed by its vertex-id.
+   * @returns size of buffer required
+   */
+  inline size_t span() const noexcept {
+    return N;
+  }
+
+  /**
+   * Get the number of vertices in the graph.
+   * @returns |V|
+   */
+  inline size_t order() const noexcept {
+    return N;
+  }
+
+  /**
+   * Obtain the number of edges in the graph.
+   * @returns |E|
+   */
+  inline size_t size() const noexcept {
+    return size_t(offsets[N] - offsets[0]);
+  }
+
+  /**
+   * Check if the graph is empty.
+   * @returns is the graph empty?
+   */
+  inline bool empty() const noexcept {
+    return N==0;
+  }
+
+  /**
+   * Check if the graph is directed.
+   * @returns is the graph directed?
+   */
+  inline bool directed() const noexcept {
+    return true;
+  }
+  #pragma endregion
+
+
+  #pragma region FOREACH
+  public:
+  /**
+   * Iterate over the vertices in the graph.
+   * @param fp process function (vertex id, vertex data)
+   */
+  template <class FP>
+  inline void forEachVertex(FP fp) const noexcept {
+    for (K u=0; u<span(); ++u)
+      fp(u, V());
+  }
+
+  /**
+   * Iterate over the vertex ids in the graph.
+   * @param fp process function (vertex id)
+   */
+  template <class FP>
+  inline void forEachVertexKey(FP fp) const noexcept {
+    for (K u=0; u<span(); ++u)
+      fp(u);
+  }
+
+  /**
+   * Iterate over the outgoing edges of a source vertex in the graph.
+   * @param u source vertex id
+   * @param fp process function (target vertex id, edge weight)
+   */
+  template <class FP>
+  inline void forEachEdge(K u, FP fp) const noexcept {
+    size_t i = offsets[u];
+    size_t I = offsets[u+1];
+    if (edgeValues) for (; i<I; ++i) fp(edgeKeys[i], edgeValues[i]);
+    else            for (; i<I; ++i) fp(edgeKeys[i], E(1));
+  }
+
+  /**
+   * Iterate over the target vertex ids of a source vertex in the graph.
+   * @param u source vertex id
+   * @param fp process function (target vertex id)
+   */
+  template <class FP>
+  inline void forEachEdgeKey(K u, FP fp) const noexcept {
+    size_t i = offsets[u];
+    size_t I = offsets[u+1];
+    for (; i<I; ++i)
+      fp(edgeKeys[i]);
+  }
+  #pragma endregion
+
+
+  #pragma region OFFSET
+  public:
+  /**
+   * Get the offset of an edge in the graph.
+   * @param u source vertex id
+   * @param v target vertex id
+   * @returns offset of the edge, or -1 if it does not exist
+   */
+  inline size_t edgeOffset(K u, K v) const noexcept {
+    if (!hasVertex(u) || !hasVertex(v)) return size_t(-1);
+    const K *ib = edgeKeys + offsets[u];
+    const K *ie = edgeKeys + offsets[u+1];
+    const K *it = find(ib, ie, v);
+    return it!=ie? it - edgeKeys : size_t(-1);
+  }
+  #pragma endregion
+
+
+  #pragma region ACCESS
+  public:
+  /**
+   * Check if a vertex exists in the graph.
+   * @param u vertex id
+   * @returns does the vertex exist?
+   */
+  inline bool hasVertex(K u) const noexcept {
+    return u < span();
+  }
+
+  /**
+   * Check if an edge exists in the graph.
+   * @param u source vertex id
+   * @param v target vertex id
+   * @returns does the edge exist?
+   */
+  inline bool hasEdge(K u, K v) const noexcept {
+    size_t o = edgeOffset(u, v);
+    return o != size_t(-1);
+  }
+
+  /**
+   * Get the number of outgoing edges of a vertex in the graph.
+   * @param u vertex id
+   * @returns number of outgoing edges of the vertex
+   */
+  inline size_t degree(K u) const noexcept {
+    return u < span()? size_t(offsets[u+1] - offsets[u]) : 0;
+  }
+
+  /**
+   * Get an outgoing edge of a vertex in the graph, by its position.
+   * @param u vertex id
+   * @param i edge index (< degree(u))
+   * @returns [target vertex id, edge weight]
+   */
+  inline pair<K, E> edgeAt(K u, size_t i) const noexcept {
+    size_t o = offsets[u] + i;
+    return make_pair(edgeKeys[o], edgeValues? edgeValues[o] : E(1));
+  }
+
+  /**
+   * Get the vertex data of a vertex in the graph.
+   * @param u vertex id
+   * @returns associated data of the vertex
+   */
+  inline V vertexValue(K u) const noexcept {
+    return V();
+  }
+
+  /**
+   * Get the edge weight of an edge in the graph.
+   * @param u source vertex id
+   * @param v target vertex id
+   * @returns associated weight of the edge
+   */
+  inline E edgeValue(K u, K v) const noexcept {
+    size_t o = edgeOffset(u, v);
+    if (o == size_t(-1)) return E();
+    return edgeValues? edgeValues[o] : E(1);
+  }
+  #pragma endregion
+  #pragma endregion
+
+
+  #pragma region CONSTRUCTORS
+  public:
+  /**
+   * View a directed graph in CSR representation.
+   * @param n number of vertices
+   * @param offsets offsets of the outgoing edges of vertices (size n+1)
+   * @param edgeKeys vertex ids of the outgoing edges of each vertex
+   * @param edgeValues edge weights of the outgoing edges of each vertex, or null for unit weights
+   */
+  DiGraphCsrView(size_t n, const O *offsets, const K *edgeKeys, const E *edgeValues=nullptr) :
+  N(n), offsets(offsets), edgeKeys(edgeKeys), edgeValues(edgeValues) {}
+  #pragma endregion
+};
+
+
+
+/**
+ * A graph whose vertex ids are dense, i.e., every id below span() exists.
+ * @tparam G underlying graph type
+ * @note Kernels skip vertex existence checks on such graphs (see IsDenseGraph),
+ * so vertices must not be removed from it. Use compactGraphOmp() to obtain one.
+ */
+template <class G>
+class DenseGraph : public G {
+  #pragma region TYPES
+  public:
+  /** Key type (vertex id). */
+  using K = typename G::key_type;
+  #pragma endregion
+
+
+  #pragma region METHODS
+  public:
+  /**
+   * Iterate over the vertex ids in the graph.
+   * @param fp process function (vertex id)
+   */
+  template <class FP>
+  inline void forEachVertexKey(FP fp) const noexcept {
+    for (K u=0; u<this->span(); ++u)
+      fp(u);
+  }
+
+  /**
+   * Check if a vertex exists in the graph.
+   * @param u vertex id
+   * @returns does the vertex exist?
+   */
+  inline bool hasVertex(K u) const noexcept {
+    return u < this->span();
+  }
+  #pragma endregion
+
+
+  #pragma region CONSTRUCTORS
+  public:
+  using G::G;
+  /**
+   * Create an empty graph.
+   */
+  DenseGraph() : G() {}
+
+  /**
+   * Mark a graph with dense vertex ids.
+   * @param x graph with dense vertex ids (moved)
+   */
+  explicit DenseGraph(G&& x) : G(move(x)) {}
+  #pragma endregion
+};
+#pragma endregion
+
+
+
+
+#pragma region TRAITS
+/**
+ * Check if a graph type has dense vertex ids, known at compile time.
+ * @tparam G graph type
+ */
+template <class G>
+struct IsDenseGraph : false_type {};
+
+template <class K, class V, class E, class O>
+struct IsDenseGraph<DiGraphCsr<K, V, E, O>> : true_type {};
+
+template <class K, class V, class E, class O>
+struct IsDenseGraph<DiGraphCsrView<K, V, E, O>> : true_type {};
+
+template <class G>
+struct IsDenseGraph<DenseGraph<G>> : true_type {};
+#pragma endregion
+
+
+
+
+#pragma region METHODS
+#pragma region ACCESS
+/**
+ * Check if a vertex exists in a graph, skipping the check on dense graphs.
+ * @param x graph
+ * @param u vertex id (must be less than span)
+ * @returns does the vertex exist?
+ */
+template <class G, class K>
+inline bool hasVertex(const G& x, K u) noexcept {
+  if constexpr (IsDenseGraph<G>::value) return true;
+  else return x.hasVertex(u);
+}
+#pragma endregion
+
+
+
+
+#pragma region WRITE
+/**
+ * Write the only the sizes of a graph to an output stream.
+ * @tparam G graph type
+ * @param a output stream
+ * @param x graph
+ */
+template <class G>
+inline void writeGraphSizes(ostream& a, const G& x) {
+  a << "order: " << x.order() << " size: " << x.size();
+  a << (x.directed()? " [directed]" : " [undirected]") << " {}";
+}
+
+/**
+ * @brief Write the full details of a graph to an output stream.
+ * @tparam G graph type
+ * @param a output stream
+ * @param x graph
+ */
+template <class G>
+inline void writeGraphDetailed(ostream& a, const G& x) {
+  a << "order: " << x.order() << " size: " << x.size();
+  a << (x.directed()? " [directed]" : " [undirected]") << " {\n";
+  x.forEachVertex([&](auto u, auto d) {
+    a << u << ":" << d << " ->";
+    x.forEachEdge(u, [&](auto v, auto w) {
+      a << " " << v << ":" << w;
+    });
+    a << "\n";
+  });
+  a << "}";
+}
 
 /**
  * Write a graph to an output stream.
@@ -703,6 +1678,20 @@ inline void write(ostream& a, const DiGraph<K, V, E>& x, bool detailed=false) {
   writeGraph(a, x, detailed);
 }
 
+/**
+ * Write a graph to an output stream.
+ * @tparam K vertex id type
+ * @tparam V vertex data type
+ * @tparam E edge weight type
+ * @param a output stream
+ * @param x graph
+ * @param detailed write detailed information?
+ */
+template <class K, class V, class E>
+inline void write(ostream& a, const DiGraphArena<K, V, E>& x, bool detailed=false) {
+  writeGraph(a, x, detailed);
+}
+
 /**
  * Write only the sizes of a graph to an output stream.
  * @tparam K vertex id type
@@ -716,5 +1705,19 @@ inline ostream& operator<<(ostream& a, const DiGraph<K, V, E>& x) {
   write(a, x);
   return a;
 }
+
+/**
+ * Write only the sizes of a graph to an output stream.
+ * @tparam K vertex id type
+ * @tparam V vertex data type
+ * @tparam E edge weight type
+ * @param a output stream
+ * @param x graph
+ */
+template <class K, class V, class E>
+inline ostream& operator<<(ostream& a, const DiGraphArena<K, V, E>& x) {
+  write(a, x);
+  return a;
+}
 #pragma endregion
 #pragma endregion
@@ -0,0 +1,220 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#ifdef OPENMP
+#include <omp.h>
+#endif
+#include "_debug.hxx"
+
+using std::unique_ptr;
+using std::vector;
+using std::max;
+
+
+
+
+#pragma region CONFIGURATION
+#ifndef ARENA_CHUNK
+/** Number of entries in each arena chunk. */
+#define ARENA_CHUNK size_t(1 << 16)
+#endif
+#ifndef ARENA_MIN_BLOCK
+/** Capacity of the smallest size class. */
+#define ARENA_MIN_BLOCK size_t(4)
+#endif
+#pragma endregion
+
+
+
+
+#pragma region CLASSES
+/**
+ * Arena that hands out power-of-two sized blocks from large chunks.
+ * @tparam T entry type
+ * @note Each thread allocates from (and frees into) its own slab, so blocks
+ * may be allocated and freed concurrently from different threads. Memory is
+ * only returned to the system on clear() or destruction.
+ */
+template <class T>
+class SlabArena {
+  #pragma region TYPES
+  protected:
+  /** Chunks and free lists owned by a single thread. */
+  struct Slab {
+    /** Allocated chunks. */
+    vector<unique_ptr<T[]>> chunks;
+    /** Free blocks, per size class. */
+    vector<vector<T*>> free;
+    /** Next free entry in the current chunk. */
+    T *next = nullptr;
+    /** Number of free entries left in the current chunk. */
+    size_t left = 0;
+    /** Number of entries in all chunks. */
+    size_t reserved = 0;
+  };
+  #pragma endregion
+
+
+  #pragma region DATA
+  protected:
+  /** Per-thread slabs. */
+  vector<Slab> slabs;
+  #pragma endregion
+
+
+  #pragma region METHODS
+  #pragma region PROPERTIES
+  public:
+  /**
+   * Get the size class for a block of given capacity.
+   * @param n required capacity
+   * @returns smallest size class with capacity >= n
+   */
+  static inline uint8_t sizeClass(size_t n) noexcept {
+    uint8_t c = 0;
+    while ((ARENA_MIN_BLOCK << c) < n) ++c;
+    return c;
+  }
+
+  /**
+   * Get the capacity of a size class.
+   * @param c size class
+   * @returns capacity of blocks in the size class
+   */
+  static inline size_t classCapacity(uint8_t c) noexcept {
+    return ARENA_MIN_BLOCK << c;
+  }
+
+  /**
+   * Get the number of entries allocated from the system.
+   * @returns total capacity of all chunks
+   */
+  inline size_t capacity() const noexcept {
+    size_t a = 0;
+    for (const auto& s : slabs)
+      a += s.reserved;
+    return a;
+  }
+  #pragma endregion
+
+
+  #pragma region HELPERS
+  protected:
+  /**
+   * Get the slab of the calling thread.
+   * @returns slab of the calling thread
+   */
+  inline Slab& currentSlab() noexcept {
+    #ifdef OPENMP
+    size_t t = omp_get_thread_num();
+    #else
+    size_t t = 0;
+    #endif
+    ASSERT(t < slabs.size());
+    return slabs[t];
+  }
+
+  /**
+   * Return the unused tail of the current chunk to the free lists.
+   * @param s slab
+   */
+  inline void carveTail(Slab& s) {
+    for (uint8_t c=sizeClass(ARENA_CHUNK); s.left >= ARENA_MIN_BLOCK;) {
+      while (classCapacity(c) > s.left) --c;
+      if (s.free.size() <= c) s.free.resize(c+1);
+      s.free[c].push_back(s.next);
+      s.next += classCapacity(c);
+      s.left -= classCapacity(c);
+    }
+    s.next = nullptr;
+    s.left = 0;
+  }
+  #pragma endregion
+
+
+  #pragma region UPDATE
+  public:
+  /**
+   * Ensure that a number of threads can use the arena.
+   * @param H number of threads
+   * @note This must not be called concurrently with allocate/free.
+   */
+  inline void reserveThreads(size_t H) {
+    if (slabs.size() < H) slabs.resize(H);
+  }
+
+  /**
+   * Allocate a block of a given size class.
+   * @param c size class
+   * @returns pointer to block (uninitialized entries)
+   */
+  inline T* allocate(uint8_t c) {
+    Slab& s = currentSlab();
+    size_t n = classCapacity(c);
+    if (s.free.size() > c && !s.free[c].empty()) {
+      T *p = s.free[c].back();
+      s.free[c].pop_back();
+      return p;
+    }
+    // Large blocks get a chunk of their own.
+    if (n > ARENA_CHUNK/4) {
+      s.chunks.emplace_back(new T[n]);
+      s.reserved += n;
+      return s.chunks.back().get();
+    }
+    if (s.left < n) {
+      carveTail(s);
+      s.chunks.emplace_back(new T[ARENA_CHUNK]);
+      s.next = s.chunks.back().get();
+      s.left = ARENA_CHUNK;
+      s.reserved += ARENA_CHUNK;
+    }
+    T *p = s.next;
+    s.next += n;
+    s.left -= n;
+    return p;
+  }
+
+  /**
+   * Free a block of a given size class.
+   * @param p pointer to block
+   * @param c size class
+   * @note The block is reused by the calling thread.
+   */
+  inline void free(T *p, uint8_t c) {
+    if (!p) return;
+    Slab& s = currentSlab();
+    if (s.free.size() <= c) s.free.resize(c+1);
+    s.free[c].push_back(p);
+  }
+
+  /**
+   * Release all memory held by the arena.
+   */
+  inline void clear() {
+    size_t H = slabs.size();
+    slabs.clear();
+    slabs.resize(H);
+  }
+  #pragma endregion
+  #pragma endregion
+
+
+  #pragma region CONSTRUCTORS
+  public:
+  /**
+   * Create an empty arena.
+   * @param H number of threads that may use the arena
+   */
+  SlabArena(size_t H=1) : slabs(max(H, size_t(1))) {}
+
+  // Blocks are owned by their users, so an arena cannot be copied.
+  SlabArena(const SlabArena&) = delete;
+  SlabArena& operator=(const SlabArena&) = delete;
+  SlabArena(SlabArena&&) = default;
+  SlabArena& operator=(SlabArena&&) = default;
+  #pragma endregion
+};
+#pragma endregion
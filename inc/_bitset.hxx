@@ -311,6 +311,38 @@ class LazyBitset {
     pairs.push_back({k, v});
     ++unprocessed;
   }
+
+  /**
+   * Remove and add entries in a single merge pass.
+   * @param dels keys to remove (sorted)
+   * @param nd number of keys to remove
+   * @param ins entries to add (sorted by key, unique)
+   * @param ni number of entries to add
+   * @note An added entry replaces any existing entry with the same key, even
+   * if that key is also removed.
+   */
+  inline void merge(const K *dels, size_t nd, const pair<K, V> *ins, size_t ni) {
+    update();
+    ssize_t i = ssize_t(pairs.size()) - 1;
+    ssize_t j = ssize_t(ni) - 1;
+    ssize_t d = ssize_t(nd) - 1;
+    size_t  k = pairs.size() + ni;
+    pairs.resize(k);
+    // Merge from the back, so that no entry is overwritten before it is read.
+    while (i>=0 || j>=0) {
+      if (j<0 || (i>=0 && pairs[i].first > ins[j].first)) {
+        K key = pairs[i].first;
+        while (d>=0 && dels[d] > key) --d;
+        if (d<0 || dels[d]!=key) pairs[--k] = pairs[i];
+        --i;
+      }
+      else {
+        if (i>=0 && pairs[i].first == ins[j].first) --i;
+        pairs[--k] = ins[j--];
+      }
+    }
+    pairs.erase(pairs.begin(), pairs.begin() + k);
+  }
   #pragma endregion
   #pragma endregion
 };
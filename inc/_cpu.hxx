@@ -0,0 +1,50 @@
+#pragma once
+
+
+
+
+#pragma region CONFIGURATION
+#ifndef CPU_MULTIVERSION
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__) && !defined(__CUDACC__)
+/** Build hot kernels for multiple instruction sets, and pick one at startup? */
+#define CPU_MULTIVERSION 1
+#else
+#define CPU_MULTIVERSION 0
+#endif
+#endif
+#pragma endregion
+
+
+
+
+#pragma region MACROS
+#if CPU_MULTIVERSION
+/**
+ * Build a function for AVX-512, AVX2 and baseline x86-64.
+ * @note The variant is picked once, at load time, by an ifunc resolver (cpuid).
+ * Functions called from within are inlined into each variant, so cloning an
+ * outer parallel kernel also covers its inner loops.
+ */
+#define CPU_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define CPU_CLONES
+#endif
+#pragma endregion
+
+
+
+
+#pragma region METHODS
+/**
+ * Get the instruction set variant of kernels picked for this CPU.
+ * @returns name of variant
+ * @note This mirrors the priority used by the ifunc resolvers.
+ */
+inline const char* cpuKernelVariant() {
+  #if CPU_MULTIVERSION
+  if (__builtin_cpu_supports("avx512f")) return "avx512f";
+  if (__builtin_cpu_supports("avx2"))    return "avx2";
+  #endif
+  return "default";
+}
+#pragma endregion
@@ -1,5 +1,6 @@
 #pragma once
 #include "_debug.hxx"
+#include "_cpu.hxx"
 #include "_algorithm.hxx"
 #include "_cmath.hxx"
 #include "_ctypes.hxx"
@@ -11,6 +12,7 @@
 #include "_vector.hxx"
 #include "_queue.hxx"
 #include "_bitset.hxx"
+#include "_arena.hxx"
 #ifdef OPENMP
 #include "_openmp.hxx"
 #endif
@@ -1,10 +1,32 @@
 #pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <algorithm>
 #include <omp.h>
 
+using std::vector;
+using std::deque;
+using std::min;
+
 
 
 
 #pragma region BELONGS
+/**
+ * Get the thread which owns a work.
+ * @param key work key
+ * @param THREADS available threads
+ * @returns owner thread
+ */
+template <class K>
+inline int ownerOmp(K key, int THREADS) {
+  const K CHUNK_SIZE = 1024;
+  K chunk = key / CHUNK_SIZE;
+  return int(chunk % THREADS);
+}
+
+
 /**
  * Check if work belongs to current thread.
  * @param key work key
@@ -14,9 +36,7 @@
  */
 template <class K>
 inline bool belongsOmp(K key, int thread, int THREADS) {
-  const K CHUNK_SIZE = 1024;
-  K chunk = key / CHUNK_SIZE;
-  return chunk % THREADS == thread;
+  return ownerOmp(key, THREADS) == thread;
 }
 
 
@@ -32,3 +52,203 @@ inline bool belongsOmp(K key) {
   return belongsOmp(key, thread, THREADS);
 }
 #pragma endregion
+
+
+
+
+#pragma region ROUTE
+/**
+ * Route items to the threads which own them, and process them there.
+ * @param buf items grouped by owner thread (scratch, resized as needed)
+ * @param cnts item counts of each thread for each owner thread (scratch)
+ * @param N number of inputs
+ * @param fe emit items for an input (i, fr), with fr(key, item)
+ * @param fp process an item on its owner thread (item)
+ * @note Inputs are split statically among threads, and items are counting
+ * sorted by owner thread in one pass, so that each thread only touches its
+ * own items. Inside fp, belongsOmp(key) is true for the key of the item.
+ */
+template <class X, class FE, class FP>
+inline void routeOmp(vector<X>& buf, vector<size_t>& cnts, size_t N, FE fe, FP fp) {
+  int H = omp_get_max_threads();
+  cnts.resize(H*H);
+  #pragma omp parallel
+  {
+    int T = omp_get_num_threads();
+    int t = omp_get_thread_num();
+    size_t chunk = (N + T - 1) / T;
+    size_t i0 = min(t * chunk, N);
+    size_t i1 = min(i0 + chunk, N);
+    size_t *cnt = &cnts[t*H];
+    // Count items for each owner.
+    for (int o=0; o<T; ++o)
+      cnt[o] = 0;
+    for (size_t i=i0; i<i1; ++i)
+      fe(i, [&](auto key, const X&) { ++cnt[ownerOmp(key, T)]; });
+    #pragma omp barrier
+    // Find where each thread writes items of each owner (owner-major).
+    #pragma omp single
+    {
+      size_t n = 0;
+      for (int o=0; o<T; ++o) {
+        for (int s=0; s<T; ++s) {
+          size_t c = cnts[s*H + o];
+          cnts[s*H + o] = n;
+          n += c;
+        }
+      }
+      if (buf.size() < n) buf.resize(n);
+    }
+    // Write items of each owner (implicit barrier above).
+    for (size_t i=i0; i<i1; ++i)
+      fe(i, [&](auto key, const X& x) { buf[cnt[ownerOmp(key, T)]++] = x; });
+    #pragma omp barrier
+    // Process own items, which are contiguous (counts now mark segment ends).
+    size_t i = t==0? 0 : cnts[(T-1)*H + t-1];
+    size_t I = cnts[(T-1)*H + t];
+    for (; i<I; ++i)
+      fp(buf[i]);
+  }
+}
+#pragma endregion
+
+
+
+
+#pragma region ATOMIC
+/**
+ * Atomically update a value to the maximum of itself and another value.
+ * @param a value to update (updated)
+ * @param v other value
+ * @returns previous value
+ */
+template <class T>
+inline T atomicMaxOmpU(T& a, T v) {
+  T x = __atomic_load_n(&a, __ATOMIC_RELAXED);
+  while (x < v && !__atomic_compare_exchange_n(&a, &x, v, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+  return x;
+}
+#pragma endregion
+
+
+
+
+#pragma region WORK QUEUE
+/**
+ * Counters of a per-thread work queue, kept on their own cache line.
+ * @note The queued count is written under the lock of its queue, and read
+ * atomically by other threads, so that they can skip empty queues without
+ * touching them.
+ */
+struct alignas(64) WorkQueueCounter {
+  /** Number of items in the queue. */
+  size_t queued = 0;
+  /** Number of items ever pushed to the queue. */
+  size_t pushed = 0;
+  /** Number of items processed by the owner thread. */
+  size_t done = 0;
+};
+
+
+/**
+ * Take work from the queue of another thread.
+ * @param qs per-thread work queues (updated)
+ * @param locks lock of each queue
+ * @param cnts counters of each queue (updated)
+ * @param t calling thread
+ * @param v work taken (updated)
+ * @returns was any work taken?
+ * @note Half of the oldest work of the first non-empty victim is moved to the
+ * queue of the calling thread, and one of it is returned.
+ */
+template <class T>
+inline bool stealWorkOmpW(vector<deque<T>>& qs, vector<omp_lock_t>& locks, vector<WorkQueueCounter>& cnts, int t, T& v) {
+  int H = qs.size();
+  vector<T> buf;
+  for (int i=1; i<H; ++i) {
+    int s = (t + i) % H;
+    if (__atomic_load_n(&cnts[s].queued, __ATOMIC_RELAXED)==0) continue;  // Confirmed under lock
+    omp_set_lock(&locks[s]);
+    size_t n = (qs[s].size() + 1) / 2;
+    buf.assign(qs[s].begin(), qs[s].begin() + n);
+    qs[s].erase(qs[s].begin(), qs[s].begin() + n);
+    __atomic_store_n(&cnts[s].queued, qs[s].size(), __ATOMIC_RELAXED);
+    omp_unset_lock(&locks[s]);
+    if (buf.empty()) continue;
+    v = buf.back(); buf.pop_back();
+    if (buf.empty()) return true;
+    omp_set_lock(&locks[t]);
+    qs[t].insert(qs[t].end(), buf.begin(), buf.end());
+    __atomic_store_n(&cnts[t].queued, qs[t].size(), __ATOMIC_RELAXED);
+    omp_unset_lock(&locks[t]);
+    return true;
+  }
+  return false;
+}
+
+
+/**
+ * Process work from per-thread queues, with work stealing, until all queues drain.
+ * @param qs per-thread work queues, seeded with initial work (updated)
+ * @param fp process function (work, push), where push(work) adds work to the calling thread's queue
+ * @param cap maximum amount of work to process
+ * @returns amount of work processed
+ * @note There are no barriers between rounds of work. Termination is detected
+ * with per-thread counters of pushed and processed work: once every counter
+ * of processed work, read before every counter of pushed work, adds up to the
+ * same total, no work is queued or in flight. Work left over after reaching
+ * the cap remains in the queues.
+ */
+template <class T, class FP>
+inline size_t drainWorkQueuesOmp(vector<deque<T>>& qs, FP fp, size_t cap=size_t(-1)) {
+  int H = qs.size();
+  vector<omp_lock_t> locks(H);
+  vector<WorkQueueCounter> cnts(H);
+  int stop = 0;
+  for (int t=0; t<H; ++t) {
+    omp_init_lock(&locks[t]);
+    cnts[t].queued = qs[t].size();
+    cnts[t].pushed = qs[t].size();
+  }
+  auto total = [&](auto fn) {
+    size_t a = 0;
+    for (int t=0; t<H; ++t)
+      a += __atomic_load_n(&fn(cnts[t]), __ATOMIC_SEQ_CST);
+    return a;
+  };
+  auto fd = [](WorkQueueCounter& c) -> size_t& { return c.done; };
+  auto fu = [](WorkQueueCounter& c) -> size_t& { return c.pushed; };
+  #pragma omp parallel num_threads(H)
+  {
+    int t = omp_get_thread_num();
+    auto push = [&](const T& v) {
+      __atomic_add_fetch(&cnts[t].pushed, 1, __ATOMIC_SEQ_CST);
+      omp_set_lock(&locks[t]);
+      qs[t].push_back(v);
+      __atomic_store_n(&cnts[t].queued, qs[t].size(), __ATOMIC_RELAXED);
+      omp_unset_lock(&locks[t]);
+    };
+    for (size_t n=0; !__atomic_load_n(&stop, __ATOMIC_RELAXED);) {
+      T    v = T();
+      bool got = false;
+      omp_set_lock(&locks[t]);
+      if (!qs[t].empty()) { v = qs[t].back(); qs[t].pop_back(); got = true; }
+      __atomic_store_n(&cnts[t].queued, qs[t].size(), __ATOMIC_RELAXED);
+      omp_unset_lock(&locks[t]);
+      if (!got) got = stealWorkOmpW(qs, locks, cnts, t, v);
+      if (got) {
+        fp(v, push);
+        __atomic_add_fetch(&cnts[t].done, 1, __ATOMIC_SEQ_CST);
+        if ((++n & 1023)==0 && total(fd) >= cap) __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+        continue;
+      }
+      size_t D = total(fd);
+      if (D==total(fu) || D>=cap) break;
+      std::this_thread::yield();
+    }
+  }
+  for (int t=0; t<H; ++t)
+    omp_destroy_lock(&locks[t]);
+  return total(fd);
+}
+#pragma endregion
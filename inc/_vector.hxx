@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <cmath>
 #include "_debug.hxx"
+#include "_cpu.hxx"
 #ifdef OPENMP
 #include <omp.h>
 #endif
@@ -387,7 +388,7 @@ inline void fillValueU(vector<T>& a, const T& v) {
  * @param v value to fill
  */
 template <class T>
-inline void fillValueOmpU(T *a, size_t N, const T& v) {
+CPU_CLONES inline void fillValueOmpU(T *a, size_t N, const T& v) {
   ASSERT(a);
   #pragma omp parallel for schedule(auto)
   for (size_t i=0; i<N; ++i)
@@ -677,7 +678,7 @@ inline TA sumValues(const vector<TX>& x, TA a=TA()) {
  * @returns sum of values
  */
 template <class TX, class TA=TX>
-inline TA sumValuesOmp(const TX *x, size_t N, TA a=TA()) {
+CPU_CLONES inline TA sumValuesOmp(const TX *x, size_t N, TA a=TA()) {
   ASSERT(x);
   #pragma omp parallel for schedule(auto) reduction(+:a)
   for (size_t i=0; i<N; ++i)
@@ -1403,7 +1404,7 @@ inline TA inclusiveScanW(vector<TA>& a, const vector<TX>& x, TA acc=TA()) {
  * @returns final value
  */
 template <class TA, class TX>
-inline TA inclusiveScanOmpW(TA *a, TA *buf, const TX *x, size_t N, TA acc=TA()) {
+CPU_CLONES inline TA inclusiveScanOmpW(TA *a, TA *buf, const TX *x, size_t N, TA acc=TA()) {
   ASSERT(a && x);
   // Each thread computes a local scan of its chunk of the input array,
   // and then the local scans are combined into a global scan.
@@ -1493,7 +1494,7 @@ inline TA exclusiveScanW(vector<TA>& a, const vector<TX>& x, TA acc=TA()) {
  * @returns final value
  */
 template <class TA, class TX>
-inline TA exclusiveScanOmpW(TA *a, TA *buf, const TX *x, size_t N, TA acc=TA()) {
+CPU_CLONES inline TA exclusiveScanOmpW(TA *a, TA *buf, const TX *x, size_t N, TA acc=TA()) {
   ASSERT(a && x);
   // Each thread computes a local scan of its chunk of the input array,
   // and then the local scans are combined into a global scan.
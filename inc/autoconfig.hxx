@@ -0,0 +1,315 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <algorithm>
+#ifdef OPENMP
+#include <omp.h>
+#endif
+#include "_main.hxx"
+#include "numa.hxx"
+#include "louvain.hxx"
+
+using std::string;
+using std::max;
+
+
+
+
+#pragma region CONFIGURATION
+#ifndef AUTO_REPLICATE_BYTES
+/** Size of graph above which a replica is kept on each NUMA node, in bytes. */
+#define AUTO_REPLICATE_BYTES size_t(64 << 20)
+#endif
+#pragma endregion
+
+
+
+
+#pragma region TYPES
+/**
+ * Cheap statistics of a graph, used to pick how to run Louvain on it.
+ */
+struct GraphStatistics {
+  #pragma region DATA
+  /** Largest vertex id + 1. */
+  size_t span;
+  /** Number of vertices. */
+  size_t order;
+  /** Number of edges. */
+  size_t size;
+  /** Largest out-degree. */
+  size_t maxDegree;
+  /** Mean out-degree. */
+  double averageDegree;
+  /** Coefficient of variation of out-degree (standard deviation / mean). */
+  double degreeVariation;
+  /** Skewness of out-degree (third standardized moment). */
+  double degreeSkewness;
+  /** Fraction of vertex ids in use (order / span). */
+  double vertexDensity;
+  /** Size of the graph in CSR form, in bytes. */
+  size_t csrBytes;
+  #pragma endregion
+};
+
+
+/**
+ * Kind of graph, as recognized from its statistics.
+ */
+enum GraphClass {
+  /** No rule matched. */
+  GRAPH_CLASS_GENERIC = 0,
+  /** Near-regular with tiny degrees, e.g. k-mer / de Bruijn graphs. */
+  GRAPH_CLASS_KMER = 1,
+  /** Low, evenly spread degrees, e.g. road networks. */
+  GRAPH_CLASS_ROAD = 2,
+  /** Heavy-tailed degrees with a few large hubs, e.g. web crawls. */
+  GRAPH_CLASS_WEB  = 3,
+  /** High average degree with moderate skew, e.g. social networks. */
+  GRAPH_CLASS_SOCIAL = 4
+};
+
+
+/**
+ * Choice of how to run Louvain on a graph.
+ */
+struct LouvainAutoConfig {
+  #pragma region DATA
+  /** Kind of graph recognized. */
+  GraphClass graphClass = GRAPH_CLASS_GENERIC;
+  /** Options for Louvain algorithm. */
+  LouvainOptions options;
+  /** Cluster a replica of the graph on each NUMA node (see DiGraphNuma)? */
+  bool replicate = false;
+  #pragma endregion
+};
+#pragma endregion
+
+
+
+
+#pragma region METHODS
+#pragma region NAMES
+/**
+ * Get the name of a kind of graph.
+ * @param x kind of graph
+ * @returns name
+ */
+inline const char* graphClassName(GraphClass x) {
+  switch (x) {
+    case GRAPH_CLASS_KMER:   return "kmer";
+    case GRAPH_CLASS_ROAD:   return "road";
+    case GRAPH_CLASS_WEB:    return "web";
+    case GRAPH_CLASS_SOCIAL: return "social";
+    default:                 return "generic";
+  }
+}
+#pragma endregion
+
+
+
+
+#pragma region STATISTICS
+#ifdef OPENMP
+/**
+ * Compute cheap statistics of a graph, in a single parallel pass over its vertices.
+ * @param x original graph
+ * @returns graph statistics
+ */
+template <class G>
+inline GraphStatistics graphStatisticsOmp(const G& x) {
+  using K = typename G::key_type;
+  using E = typename G::edge_value_type;
+  size_t S = x.span(), N = x.order(), M = x.size(), dmax = 0;
+  double d1 = 0, d2 = 0, d3 = 0;
+  #pragma omp parallel for schedule(static, 2048) reduction(+:d1, d2, d3) reduction(max:dmax)
+  for (size_t u=0; u<S; ++u) {
+    if (!x.hasVertex(K(u))) continue;
+    size_t d = x.degree(K(u));
+    d1  += double(d);
+    d2  += double(d)*d;
+    d3  += double(d)*d*d;
+    dmax = max(dmax, d);
+  }
+  GraphStatistics a = {};
+  a.span  = S;
+  a.order = N;
+  a.size  = M;
+  a.maxDegree = dmax;
+  a.vertexDensity = S? double(N)/S : 1;
+  a.csrBytes = (N+1)*sizeof(size_t) + M*(sizeof(K) + sizeof(E));
+  if (N==0) return a;
+  double mu  = d1/N;
+  double var = max(d2/N - mu*mu, 0.0);
+  double sd  = sqrt(var);
+  a.averageDegree   = mu;
+  a.degreeVariation = mu>0? sd/mu : 0;
+  a.degreeSkewness  = sd>0? (d3/N - 3*mu*var - mu*mu*mu) / (var*sd) : 0;
+  return a;
+}
+#endif
+#pragma endregion
+
+
+
+
+#pragma region CONFIGURE
+/**
+ * Choose how to run Louvain on a graph, from its statistics.
+ * @param s graph statistics
+ * @param nodes number of NUMA nodes the threads run on
+ * @returns chosen configuration
+ * @note Rules are checked in order, and the first match decides the kind of graph:
+ *
+ * | Kind    | Rule                         | async | prune | sample |
+ * |---------|------------------------------|-------|-------|--------|
+ * | kmer    | max degree <= 8, avg <= 4    | yes   | 1     | -      |
+ * | road    | max degree <= 64, avg <= 8   | no    | 2     | -      |
+ * | web     | degree variation >= 4        | no    | 4     | 512    |
+ * | social  | avg degree >= 16             | no    | 8     | -      |
+ * | generic | otherwise                    | no    | -     | -      |
+ *
+ * On chain-like kmer graphs, asynchronous moves carry a label along a chain
+ * within one iteration. On kmer and road graphs most vertices settle after a
+ * move or two, so they are pruned early. On web graphs a few hubs dominate
+ * the scan cost, so they scan a sample of their edges. Social graphs keep
+ * moving for longer, so they are pruned late. Independently, a replica of the
+ * graph is kept on each NUMA node if the threads span several nodes and the
+ * graph is larger than AUTO_REPLICATE_BYTES. Edge weight precision (TYPE),
+ * hashtable layout and loop schedules are fixed at build time, and are not
+ * chosen here.
+ */
+inline LouvainAutoConfig louvainAutoConfigure(const GraphStatistics& s, int nodes=1) {
+  LouvainAutoConfig a;
+  LouvainOptions& o = a.options;
+  if (s.maxDegree<=8 && s.averageDegree<=4) {
+    a.graphClass = GRAPH_CLASS_KMER;
+    o.asynchronous = true;
+    o.pruningThreshold = 1;
+  }
+  else if (s.maxDegree<=64 && s.averageDegree<=8) {
+    a.graphClass = GRAPH_CLASS_ROAD;
+    o.pruningThreshold = 2;
+  }
+  else if (s.degreeVariation>=4) {
+    a.graphClass = GRAPH_CLASS_WEB;
+    o.pruningThreshold = 4;
+    o.samplingDegree   = 512;
+  }
+  else if (s.averageDegree>=16) {
+    a.graphClass = GRAPH_CLASS_SOCIAL;
+    o.pruningThreshold = 8;
+  }
+  a.replicate = nodes>1 && s.csrBytes>=AUTO_REPLICATE_BYTES;
+  return a;
+}
+
+
+#ifdef OPENMP
+/**
+ * Choose how to run Louvain on a graph, from its statistics.
+ * @param x original graph
+ * @returns chosen configuration
+ */
+template <class G>
+inline LouvainAutoConfig louvainAutoConfigureOmp(const G& x) {
+  return louvainAutoConfigure(graphStatisticsOmp(x), numaNodesOmp());
+}
+#endif
+#pragma endregion
+
+
+
+
+#pragma region OVERRIDE
+/**
+ * Set an option of Louvain algorithm, given as key=value.
+ * @param a louvain options (updated)
+ * @param kv option as key=value, where key is a field of LouvainOptions
+ * @returns is the option known?
+ */
+inline bool readLouvainOptionW(LouvainOptions& a, const string& kv) {
+  size_t i = kv.find('=');
+  if (i==string::npos) return false;
+  string k = kv.substr(0, i);
+  double v = atof(kv.c_str() + i+1);
+  if      (k=="repeat")     a.repeat = int(v);
+  else if (k=="resolution") a.resolution = v;
+  else if (k=="tolerance")  a.tolerance = v;
+  else if (k=="aggregationTolerance") a.aggregationTolerance = v;
+  else if (k=="toleranceDrop") a.toleranceDrop = v;
+  else if (k=="maxIterations") a.maxIterations = int(v);
+  else if (k=="maxPasses")  a.maxPasses = int(v);
+  else if (k=="asynchronous")     a.asynchronous = v!=0;
+  else if (k=="pruningThreshold") a.pruningThreshold = int(v);
+  else if (k=="samplingDegree")   a.samplingDegree = int(v);
+  else if (k=="samplingMargin")   a.samplingMargin = v;
+  else return false;
+  return true;
+}
+
+
+/**
+ * Override a choice of how to run Louvain, given as key=value.
+ * @param a chosen configuration (updated)
+ * @param kv choice as key=value, where key is a field of LouvainOptions, or "replicate"
+ * @returns is the choice known?
+ */
+inline bool overrideLouvainAutoConfigW(LouvainAutoConfig& a, const string& kv) {
+  if (kv.compare(0, 10, "replicate=")==0) { a.replicate = atoi(kv.c_str() + 10)!=0; return true; }
+  return readLouvainOptionW(a.options, kv);
+}
+
+
+/**
+ * Override choices of how to run Louvain, given as a list of key=value.
+ * @param a chosen configuration (updated)
+ * @param kvs choices separated by spaces or commas, e.g. "samplingDegree=0,replicate=1"
+ * @returns are all choices known? (known ones are applied regardless)
+ */
+inline bool overrideLouvainAutoConfigW(LouvainAutoConfig& a, const char *kvs) {
+  bool ok = true;
+  string s = kvs? kvs : "";
+  for (size_t i=0; i<s.size();) {
+    size_t j = s.find_first_of(" ,", i);
+    if (j==string::npos) j = s.size();
+    if (j>i) ok &= overrideLouvainAutoConfigW(a, s.substr(i, j-i));
+    i = j+1;
+  }
+  return ok;
+}
+#pragma endregion
+
+
+
+
+#pragma region PRINT
+/**
+ * Print graph statistics, on one line.
+ * @param s graph statistics
+ */
+inline void printGraphStatistics(const GraphStatistics& s) {
+  printf(
+    "{%zu span, %zu order, %zu size, %zu max degree, %.2f avg degree, %.2f variation, %.2f skewness, %.3f density, %.1fMB csr} analyze\n",
+    s.span, s.order, s.size, s.maxDegree, s.averageDegree, s.degreeVariation, s.degreeSkewness, s.vertexDensity, s.csrBytes/1e6
+  );
+}
+
+
+/**
+ * Print a choice of how to run Louvain, on one line.
+ * @param a chosen configuration
+ */
+inline void printLouvainAutoConfig(const LouvainAutoConfig& a) {
+  const LouvainOptions& o = a.options;
+  printf(
+    "{%s class, asynchronous=%d pruningThreshold=%d samplingDegree=%d samplingMargin=%g tolerance=%g aggregationTolerance=%g maxIterations=%d maxPasses=%d replicate=%d} autoconfig\n",
+    graphClassName(a.graphClass), o.asynchronous, o.pruningThreshold, o.samplingDegree, o.samplingMargin,
+    o.tolerance, o.aggregationTolerance, o.maxIterations, o.maxPasses, a.replicate
+  );
+}
+#pragma endregion
+#pragma endregion
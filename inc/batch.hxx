@@ -5,11 +5,16 @@
 #include "_main.hxx"
 #include "update.hxx"
 
+using std::pair;
 using std::tuple;
 using std::vector;
 using std::uniform_real_distribution;
 using std::make_tuple;
+using std::get;
+using std::min;
+using std::max;
 using std::sort;
+using std::is_sorted;
 using std::unique;
 using std::remove_if;
 
@@ -176,6 +181,61 @@ inline void sortEdgesByIdU(vector<tuple<K, K, V>>& edges) {
 }
 
 
+#ifdef OPENMP
+/**
+ * Sort edges in batch update by source/destination vertex.
+ * @param a sorted edges (updated)
+ * @param x edges in batch update
+ * @note Edges are scattered into buckets by ranges of source vertex ids
+ * (counting per thread), and each bucket is then sorted on its own.
+ */
+template <class K, class V>
+inline void sortEdgesByIdOmpW(vector<tuple<K, K, V>>& a, const vector<tuple<K, K, V>>& x) {
+  auto fl = [](const auto& p, const auto& q) { return get<0>(p)<get<0>(q) || (get<0>(p)==get<0>(q) && get<1>(p)<get<1>(q)); };
+  size_t N  = x.size();
+  size_t TM = omp_get_max_threads();
+  size_t P  = max(min(N/1024, 64*TM), size_t(1));
+  size_t S  = 0;
+  a.resize(N);
+  #pragma omp parallel for schedule(static, 2048) reduction(max:S)
+  for (size_t i=0; i<N; ++i)
+    S = max(S, size_t(get<0>(x[i])) + 1);
+  vector<size_t> cnts(TM*P + 1), boff(P+1);
+  size_t T = 1;
+  #pragma omp parallel
+  {
+    size_t t = omp_get_thread_num();
+    #pragma omp single
+    T = omp_get_num_threads();
+    // Each thread counts, and later scatters, its own slice of edges.
+    size_t i0 = N*t/T, i1 = N*(t+1)/T;
+    for (size_t i=i0; i<i1; ++i)
+      ++cnts[t*P + size_t(get<0>(x[i]))*P/S];
+    #pragma omp barrier
+    #pragma omp single
+    {
+      size_t n = 0;
+      for (size_t b=0; b<P; ++b) {
+        boff[b] = n;
+        for (size_t r=0; r<T; ++r) {
+          size_t c = cnts[r*P + b];
+          cnts[r*P + b] = n;
+          n += c;
+        }
+      }
+      boff[P] = n;
+    }
+    for (size_t i=i0; i<i1; ++i)
+      a[cnts[t*P + size_t(get<0>(x[i]))*P/S]++] = x[i];
+    #pragma omp barrier
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t b=0; b<P; ++b)
+      sort(a.begin() + boff[b], a.begin() + boff[b+1], fl);
+  }
+}
+#endif
+
+
 /**
  * Keep only unique edges in batch update.
  * @param edges edges in batch update (updated)
@@ -231,20 +291,137 @@ inline void applyBatchUpdateU(G& a, const vector<tuple<K, K, V>>& deletions, con
 
 
 #ifdef OPENMP
+/**
+ * Find where each run of equal keys begins, in a sorted array.
+ * @param a index of the first entry of each run, followed by the size of keys (updated)
+ * @param bufs buffer for exclusive scan of size |threads| (scratch)
+ * @param x keys (sorted)
+ */
+template <class K>
+inline void batchRunStartsOmpW(vector<size_t>& a, vector<size_t>& bufs, const vector<K>& x) {
+  size_t N = x.size();
+  vector<size_t> pos(N);
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t i=0; i<N; ++i)
+    pos[i] = i==0 || x[i]!=x[i-1];
+  size_t R = exclusiveScanOmpW(pos.data(), bufs.data(), pos.data(), N);
+  a.resize(R+1);
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t i=0; i<N; ++i)
+    if (i==0 || x[i]!=x[i-1]) a[pos[i]] = i;
+  a[R] = N;
+}
+
+
 /**
  * Apply a batch update to a graph.
  * @param a input graph (updated)
  * @param deletions edge deletions in batch update
  * @param insertions edge insertions in batch update
+ * @note The graph must be up to date (see updateOmpU). The batch is grouped
+ * by source vertex (sorted in parallel, unless it already is, see
+ * tidyBatchUpdateU), and only the rows it touches are merged, each once. Time and memory depend on
+ * the size of the batch, not the span of the graph.
  */
 template <class G, class K, class V>
 inline void applyBatchUpdateOmpU(G& a, const vector<tuple<K, K, V>>& deletions, const vector<tuple<K, K, V>>& insertions) {
-  for (auto [u, v, w] : deletions)
-    a.removeEdge(u, v);
-  updateOmpU(a);
-  for (auto [u, v, w] : insertions)
-    a.addEdge(u, v, w);
-  updateOmpU(a);
+  using  E = typename G::edge_value_type;
+  int    T = omp_get_max_threads();
+  size_t D = deletions.size();
+  size_t I = insertions.size();
+  ssize_t dn = 0, dm = 0;
+  vector<size_t> bufs(T);
+  // Grow the graph once, to the largest new vertex id.
+  size_t S = a.span();
+  #pragma omp parallel for schedule(static, 2048) reduction(max:S)
+  for (size_t i=0; i<I; ++i)
+    S = max(S, size_t(max(get<0>(insertions[i]), get<1>(insertions[i]))) + 1);
+  if (S > a.span()) a.respan(S);
+  // Add new vertices, with each thread owning blocks of 4096 ids (vertex existence flags are bits).
+  vector<vector<K>> nvt(T);
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t i=0; i<I; ++i) {
+    int t = omp_get_thread_num();
+    auto [u, v, w] = insertions[i];
+    if (!a.hasVertex(u)) nvt[t].push_back(u);
+    if (!a.hasVertex(v)) nvt[t].push_back(v);
+  }
+  vector<K> nvs, nblk;
+  for (int t=0; t<T; ++t)
+    nvs.insert(nvs.end(), nvt[t].begin(), nvt[t].end());
+  sort(nvs.begin(), nvs.end());
+  nvs.erase(unique(nvs.begin(), nvs.end()), nvs.end());
+  dn = nvs.size();
+  nblk.resize(dn);
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t i=0; i<size_t(dn); ++i)
+    nblk[i] = nvs[i] >> 12;
+  vector<size_t> nrow;
+  batchRunStartsOmpW(nrow, bufs, nblk);
+  size_t NR = nrow.size() - 1;
+  #pragma omp parallel for schedule(dynamic, 16)
+  for (size_t r=0; r<NR; ++r) {
+    for (size_t i=nrow[r]; i<nrow[r+1]; ++i)
+      a.addVertex(nvs[i]);
+  }
+  // Group deletions and insertions by source vertex.
+  auto fl = [](const auto& p, const auto& q) { return get<0>(p)<get<0>(q) || (get<0>(p)==get<0>(q) && get<1>(p)<get<1>(q)); };
+  vector<tuple<K, K, V>> dsrt, isrt;
+  const auto *dp = &deletions, *ip = &insertions;
+  if (!is_sorted(deletions .begin(), deletions .end(), fl)) { sortEdgesByIdOmpW(dsrt, deletions);  dp = &dsrt; }
+  if (!is_sorted(insertions.begin(), insertions.end(), fl)) { sortEdgesByIdOmpW(isrt, insertions); ip = &isrt; }
+  vector<K> dsrc(D), dedg(D), isrc(I);
+  vector<pair<K, E>> iedg(I);
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t i=0; i<D; ++i) {
+    dsrc[i] = get<0>((*dp)[i]);
+    dedg[i] = get<1>((*dp)[i]);
+  }
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t i=0; i<I; ++i) {
+    isrc[i] = get<0>((*ip)[i]);
+    iedg[i] = {get<1>((*ip)[i]), E(get<2>((*ip)[i]))};
+  }
+  vector<size_t> drow, irow;
+  batchRunStartsOmpW(drow, bufs, dsrc);
+  batchRunStartsOmpW(irow, bufs, isrc);
+  size_t DR = drow.size() - 1;
+  size_t IR = irow.size() - 1;
+  // Find the run of a source vertex, if it has one.
+  auto ff = [](const vector<size_t>& rows, const vector<K>& src, size_t R, K u) {
+    size_t l = 0, h = R;
+    while (l<h) {
+      size_t m = (l+h)/2;
+      if (src[rows[m]] < u) l = m+1;
+      else h = m;
+    }
+    return l<R && src[rows[l]]==u? l : R;
+  };
+  // Merge changes into a touched row.
+  auto fe = [](const auto& p, const auto& q) { return p.first == q.first; };
+  auto fm = [&](K u, size_t d0, size_t nd, size_t i0, size_t ni) {
+    if (!a.hasVertex(u)) return ssize_t();
+    pair<K, E> *ib = iedg.data() + i0;
+    ni = unique(ib, ib + ni, fe) - ib;
+    ssize_t g0 = a.degree(u);
+    a.mergeEdges(u, dedg.data() + d0, nd, ib, ni);
+    return ssize_t(a.degree(u)) - g0;
+  };
+  // Rows with deletions (and maybe insertions), then rows with only insertions.
+  #pragma omp parallel for schedule(dynamic, 64) reduction(+:dm)
+  for (size_t r=0; r<DR; ++r) {
+    K u = dsrc[drow[r]];
+    size_t s = ff(irow, isrc, IR, u);
+    if (s<IR) dm += fm(u, drow[r], drow[r+1]-drow[r], irow[s], irow[s+1]-irow[s]);
+    else      dm += fm(u, drow[r], drow[r+1]-drow[r], 0, 0);
+  }
+  #pragma omp parallel for schedule(dynamic, 64) reduction(+:dm)
+  for (size_t s=0; s<IR; ++s) {
+    K u = isrc[irow[s]];
+    if (ff(drow, dsrc, DR, u)<DR) continue;
+    dm += fm(u, 0, 0, irow[s], irow[s+1]-irow[s]);
+  }
+  a.adjustSize(dn, dm);
 }
 #endif
 #pragma endregion
@@ -1,6 +1,11 @@
 #pragma once
+#include <cstdint>
 #include <utility>
 #include <vector>
+#ifdef OPENMP
+#include <omp.h>
+#endif
+#include "_main.hxx"
 
 using std::vector;
 using std::swap;
@@ -8,6 +13,24 @@ using std::swap;
 
 
 
+#pragma region CONFIGURATION
+#ifndef BFS_ALPHA
+/** Switch parallel BFS to bottom-up when edges out of the frontier exceed unexplored edges / BFS_ALPHA. */
+#define BFS_ALPHA 15
+#endif
+#ifndef BFS_BETA
+/** Switch parallel BFS back to top-down when a shrinking frontier has fewer than span / BFS_BETA vertices. */
+#define BFS_BETA  18
+#endif
+#ifndef BFS_SERIAL_EDGES
+/** Explore a level of parallel BFS on one thread, if its frontier has fewer edges than this. */
+#define BFS_SERIAL_EDGES 4096
+#endif
+#pragma endregion
+
+
+
+
 #pragma region METHODS
 /**
  * Find vertices visited with BFS.
@@ -71,3 +94,222 @@ inline vector<FLAG> bfsVisitedForEach(const G& x, K u, FT ft, FP fp) {
   return vis;
 }
 #pragma endregion
+
+
+
+
+#pragma region BITMAP
+/**
+ * Check if a bit is set in a bitmap.
+ * @param a bitmap, 64 bits per word
+ * @param i bit index
+ * @returns is bit set?
+ * @note This is a relaxed atomic load, so it can race with bitmapSetOmp().
+ */
+inline bool bitmapGet(const vector<uint64_t>& a, size_t i) noexcept {
+  return (__atomic_load_n(&a[i>>6], __ATOMIC_RELAXED) >> (i & 63)) & 1;
+}
+
+
+/**
+ * Set a bit in a bitmap, atomically.
+ * @param a bitmap, 64 bits per word (updated)
+ * @param i bit index
+ * @returns was the bit set by this call (i.e., was it unset before)?
+ */
+inline bool bitmapSetOmp(vector<uint64_t>& a, size_t i) noexcept {
+  uint64_t m = uint64_t(1) << (i & 63);
+  if (__atomic_load_n(&a[i>>6], __ATOMIC_RELAXED) & m) return false;
+  return !(__atomic_fetch_or(&a[i>>6], m, __ATOMIC_RELAXED) & m);
+}
+
+
+/**
+ * Get the number of bitmap words needed for a number of bits.
+ * @param N number of bits
+ * @returns number of 64-bit words
+ */
+inline size_t bitmapWords(size_t N) noexcept {
+  return (N + 63) / 64;
+}
+#pragma endregion
+
+
+
+
+#ifdef OPENMP
+#pragma region PARALLEL BFS
+/**
+ * Find vertices visited with direction-optimizing BFS, in parallel.
+ * @param vis vertex visited bitmap, with bitmapWords(span) words (updated)
+ * @param x original graph (symmetric)
+ * @param us start vertices
+ * @param ft should vertex be visited? (vertex, depth)
+ * @param fp action to perform on every visited vertex (vertex, depth), called in parallel
+ * @returns number of vertices visited
+ * @note Each level is explored top-down (frontier vertices claim their
+ * unvisited neighbors) while the frontier is small, and bottom-up (unvisited
+ * vertices look for a parent in the frontier, stopping at the first one)
+ * while it is large [1]. Top-down frontiers are vertex lists, and bottom-up
+ * frontiers are bitmaps, where each word is owned by one thread. Levels with
+ * very few edges are explored on one thread, to avoid fork-join overhead on
+ * long, thin graphs (e.g. road networks). The bottom-up step looks for parents among out-edges, so the graph must be
+ * symmetric. Vertices at the same depth are visited in no particular order.
+ * [1]: Beamer, S., Asanović, K., & Patterson, D. (2012). Direction-optimizing breadth-first search.
+ */
+template <class G, class K, class FT, class FP>
+inline size_t bfsVisitedForEachOmpU(vector<uint64_t>& vis, const G& x, const vector<K>& us, FT ft, FP fp) {
+  size_t S = x.span(), W = bitmapWords(S), M = x.size();
+  int    T = omp_get_max_threads();
+  vector2d<K> bufs(T);
+  vector<size_t> offs(T+1);
+  vector<K> cur;
+  vector<uint64_t> fcur, fnxt;
+  size_t nv = 0, nf = 0, np = 0, mf = 0, mu = M;
+  int    R = T;  // Team size of the last parallel region
+  for (K u : us) {
+    if (bitmapGet(vis, u) || !ft(u, K())) continue;
+    vis[u>>6] |= uint64_t(1) << (u & 63);
+    fp(u, K());
+    cur.push_back(u);
+    mf += x.degree(u);
+  }
+  nf = nv = cur.size();
+  bool bottomUp = false;
+  for (K d=1; nf>0; ++d) {
+    mu = mu>mf? mu-mf : 0;
+    // Switch to bottom-up, converting the frontier list to a bitmap.
+    if (!bottomUp && mf > mu/BFS_ALPHA) {
+      bottomUp = true;
+      fcur.resize(W); fnxt.resize(W);
+      fillValueOmpU(fcur, uint64_t());
+      #pragma omp parallel for schedule(static, 2048)
+      for (size_t i=0; i<nf; ++i)
+        bitmapSetOmp(fcur, cur[i]);
+    }
+    // Switch back to top-down, converting the frontier bitmap to a list.
+    else if (bottomUp && nf < np && nf < S/BFS_BETA) {
+      bottomUp = false;
+      #pragma omp parallel
+      {
+        auto& b = bufs[omp_get_thread_num()];
+        b.clear();
+        #pragma omp single nowait
+        R = omp_get_num_threads();
+        #pragma omp for schedule(static, 256)
+        for (size_t w=0; w<W; ++w) {
+          for (uint64_t f=fcur[w]; f; f&=f-1)
+            b.push_back(K(w*64 + __builtin_ctzll(f)));
+        }
+      }
+      cur.clear();
+      for (int t=0; t<R; ++t)
+        cur.insert(cur.end(), bufs[t].begin(), bufs[t].end());
+    }
+    size_t nn = 0, mn = 0;
+    if (!bottomUp && mf < BFS_SERIAL_EDGES) {
+      // Top-down, on one thread: a tiny frontier is not worth a parallel region.
+      auto& b = bufs[0];
+      b.clear();
+      for (size_t i=0; i<nf; ++i) {
+        x.forEachEdgeKey(cur[i], [&](auto v) {
+          if (bitmapGet(vis, v) || !ft(v, d) || !bitmapSetOmp(vis, v)) return;
+          fp(v, d);
+          b.push_back(v);
+          mn += x.degree(v);
+        });
+      }
+      swap(cur, b);
+      nn = cur.size();
+    }
+    else if (!bottomUp) {
+      // Top-down: claim unvisited neighbors of the frontier.
+      #pragma omp parallel reduction(+:mn)
+      {
+        int t = omp_get_thread_num();
+        auto& b = bufs[t];
+        b.clear();
+        #pragma omp for schedule(dynamic, 64) nowait
+        for (size_t i=0; i<nf; ++i) {
+          x.forEachEdgeKey(cur[i], [&](auto v) {
+            if (bitmapGet(vis, v) || !ft(v, d) || !bitmapSetOmp(vis, v)) return;
+            fp(v, d);
+            b.push_back(v);
+            mn += x.degree(v);
+          });
+        }
+        offs[t+1] = b.size();
+        #pragma omp barrier
+        #pragma omp single
+        {
+          R = omp_get_num_threads();
+          for (int s=0; s<R; ++s)
+            offs[s+1] += offs[s];
+          cur.resize(offs[R]);
+        }
+        copy(b.begin(), b.end(), cur.begin() + offs[t]);
+      }
+      nn = cur.size();
+    }
+    else {
+      // Bottom-up: find a parent in the frontier for each unvisited vertex.
+      #pragma omp parallel for schedule(dynamic, 256) reduction(+:nn, mn)
+      for (size_t w=0; w<W; ++w) {
+        uint64_t un  = ~vis[w], add = 0;
+        if (w==W-1 && S%64) un &= (uint64_t(1) << (S%64)) - 1;
+        for (; un; un&=un-1) {
+          int  b = __builtin_ctzll(un);
+          K    v = K(w*64 + b);
+          if (!x.hasVertex(v) || !ft(v, d)) continue;
+          size_t D = x.degree(v);
+          for (size_t i=0; i<D; ++i) {
+            if (!bitmapGet(fcur, x.edgeAt(v, i).first)) continue;
+            add |= uint64_t(1) << b;
+            fp(v, d);
+            ++nn; mn += D;
+            break;
+          }
+        }
+        vis[w] |= add;
+        fnxt[w] = add;
+      }
+      swap(fcur, fnxt);
+    }
+    nv += nn; np = nf; nf = nn; mf = mn;
+  }
+  return nv;
+}
+
+
+/**
+ * Find vertices visited with direction-optimizing BFS, in parallel.
+ * @param vis vertex visited bitmap, with bitmapWords(span) words (updated)
+ * @param x original graph (symmetric)
+ * @param u start vertex
+ * @param ft should vertex be visited? (vertex, depth)
+ * @param fp action to perform on every visited vertex (vertex, depth), called in parallel
+ * @returns number of vertices visited
+ */
+template <class G, class K, class FT, class FP>
+inline size_t bfsVisitedForEachOmpU(vector<uint64_t>& vis, const G& x, K u, FT ft, FP fp) {
+  vector<K> us {u};
+  return bfsVisitedForEachOmpU(vis, x, us, ft, fp);
+}
+
+
+/**
+ * Find vertices visited with direction-optimizing BFS, in parallel.
+ * @param x original graph (symmetric)
+ * @param u start vertex
+ * @param ft should vertex be visited? (vertex, depth)
+ * @param fp action to perform on every visited vertex (vertex, depth), called in parallel
+ * @returns vertex visited bitmap (see bitmapGet)
+ */
+template <class G, class K, class FT, class FP>
+inline vector<uint64_t> bfsVisitedForEachOmp(const G& x, K u, FT ft, FP fp) {
+  vector<uint64_t> vis(bitmapWords(x.span()));
+  bfsVisitedForEachOmpU(vis, x, u, ft, fp);
+  return vis;
+}
+#pragma endregion
+#endif
@@ -0,0 +1,312 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <fstream>
+#include "_main.hxx"
+#include "Graph.hxx"
+#include "fingerprint.hxx"
+
+using std::vector;
+using std::istream;
+using std::ostream;
+using std::ifstream;
+using std::ofstream;
+
+
+
+
+#pragma region TYPES
+/** Magic number at the start of every binary file ("GVEB"). */
+#define BINARY_MAGIC   0x42455647u
+/** Version of the binary file format (2: CSR bodies end with a fingerprint). */
+#define BINARY_VERSION 2u
+
+
+/**
+ * Kind of data stored in a binary file.
+ */
+enum BinaryKind : uint32_t {
+  /** Plain array of values. */
+  BINARY_VALUES = 1,
+  /** Graph in CSR format. */
+  BINARY_CSR    = 2,
+  /** Checkpoint of Louvain algorithm between passes. */
+  BINARY_LOUVAIN_CHECKPOINT = 3,
+  /** Graph in CSR format, in a shared memory segment. */
+  BINARY_SHARED_CSR = 4,
+  /** Cached result of Louvain algorithm. */
+  BINARY_LOUVAIN_RESULT = 5
+};
+
+
+/**
+ * Header of a binary file.
+ */
+struct BinaryHeader {
+  #pragma region DATA
+  /** Magic number (BINARY_MAGIC). */
+  uint32_t magic;
+  /** Version of the format (BINARY_VERSION). */
+  uint32_t version;
+  /** Kind of data stored. */
+  uint32_t kind;
+  /** Size of key type in bytes. */
+  uint32_t keySize;
+  /** Size of value/weight type in bytes. */
+  uint32_t valueSize;
+  /** Size of offset type in bytes. */
+  uint32_t offsetSize;
+  #pragma endregion
+};
+#pragma endregion
+
+
+
+
+#pragma region METHODS
+#pragma region FINGERPRINT
+/**
+ * Obtain the fingerprint of an array of values written to a binary file.
+ * @param x values
+ * @param N number of values
+ * @returns 64-bit fingerprint
+ */
+template <class T>
+inline uint64_t binaryFingerprint(const T *x, size_t N) {
+  #ifdef OPENMP
+  return fingerprintValuesOmp(x, N);
+  #else
+  return fingerprintValues(x, N);
+  #endif
+}
+
+
+/**
+ * Obtain the fingerprint of the body of a CSR graph in a binary file.
+ * @param x graph in CSR format
+ * @param S number of vertices written
+ * @param M number of edges written
+ * @returns 64-bit fingerprint of offsets, degrees, edge keys and edge values
+ */
+template <class K, class V, class E, class O>
+inline uint64_t binaryCsrFingerprint(const DiGraphCsr<K, V, E, O>& x, size_t S, size_t M) {
+  uint64_t h = binaryFingerprint(x.offsets.data(), S+1);
+  h = fingerprintStep(h, binaryFingerprint(x.degrees.data(), S));
+  h = fingerprintStep(h, binaryFingerprint(x.edgeKeys.data(),   M));
+  h = fingerprintStep(h, binaryFingerprint(x.edgeValues.data(), M));
+  return fingerprintMix(h);
+}
+#pragma endregion
+
+
+
+
+#pragma region WRITE BINARY
+/**
+ * Write a plain value to a binary stream.
+ * @param a output stream
+ * @param v value to write
+ */
+template <class T>
+inline void writeBinaryValue(ostream& a, const T& v) {
+  a.write((const char*) &v, sizeof(T));
+}
+
+
+/**
+ * Write an array of values to a binary stream, prefixed by its size.
+ * @param a output stream
+ * @param x values to write
+ * @param N number of values
+ */
+template <class T>
+inline void writeBinaryValues(ostream& a, const T *x, size_t N) {
+  writeBinaryValue(a, uint64_t(N));
+  if (N>0) a.write((const char*) x, N * sizeof(T));
+}
+
+/**
+ * Write a vector of values to a binary stream, prefixed by its size.
+ * @param a output stream
+ * @param x values to write
+ */
+template <class T>
+inline void writeBinaryValues(ostream& a, const vector<T>& x) {
+  writeBinaryValues(a, x.data(), x.size());
+}
+
+
+/**
+ * Write header of a binary file.
+ * @param a output stream
+ * @param kind kind of data stored
+ * @param keySize size of key type in bytes
+ * @param valueSize size of value/weight type in bytes
+ * @param offsetSize size of offset type in bytes
+ */
+inline void writeBinaryHeader(ostream& a, BinaryKind kind, size_t keySize, size_t valueSize, size_t offsetSize=0) {
+  BinaryHeader h = {BINARY_MAGIC, BINARY_VERSION, kind, uint32_t(keySize), uint32_t(valueSize), uint32_t(offsetSize)};
+  writeBinaryValue(a, h);
+}
+
+
+/**
+ * Write the body of a CSR graph to a binary stream (no header).
+ * @param a output stream
+ * @param x graph in CSR format
+ * @note Only the first offsets[span] edges are written. The body ends with a
+ * fingerprint of its arrays, which is checked when it is read back.
+ */
+template <class K, class V, class E, class O>
+inline void writeBinaryCsrBody(ostream& a, const DiGraphCsr<K, V, E, O>& x) {
+  size_t S = x.span();
+  size_t M = S>0? size_t(x.offsets[S]) : 0;
+  writeBinaryValues(a, x.offsets.data(), S+1);
+  writeBinaryValues(a, x.degrees);
+  writeBinaryValues(a, x.edgeKeys.data(),   M);
+  writeBinaryValues(a, x.edgeValues.data(), M);
+  writeBinaryValue(a, binaryCsrFingerprint(x, S, M));
+}
+
+
+/**
+ * Write a CSR graph to a binary stream.
+ * @param a output stream
+ * @param x graph in CSR format
+ */
+template <class K, class V, class E, class O>
+inline void writeBinaryCsr(ostream& a, const DiGraphCsr<K, V, E, O>& x) {
+  writeBinaryHeader(a, BINARY_CSR, sizeof(K), sizeof(E), sizeof(O));
+  writeBinaryCsrBody(a, x);
+}
+template <class K, class V, class E, class O>
+inline void writeBinaryCsr(const char *pth, const DiGraphCsr<K, V, E, O>& x) {
+  ofstream a(pth, std::ios::binary);
+  writeBinaryCsr(a, x);
+}
+#pragma endregion
+
+
+
+
+#pragma region READ BINARY
+/**
+ * Read a plain value from a binary stream.
+ * @param v value read (updated)
+ * @param s input stream
+ * @returns success?
+ */
+template <class T>
+inline bool readBinaryValueW(T& v, istream& s) {
+  return bool(s.read((char*) &v, sizeof(T)));
+}
+
+
+/**
+ * Get the number of bytes left to read in a binary stream.
+ * @param s input stream
+ * @returns number of bytes left, or SIZE_MAX if the stream cannot seek
+ */
+inline size_t readBinaryBytesLeft(istream& s) {
+  auto i = s.tellg();
+  if (i<0) return SIZE_MAX;
+  s.seekg(0, std::ios::end);
+  auto e = s.tellg();
+  s.clear();
+  s.seekg(i);
+  return e<i? SIZE_MAX : size_t(e - i);
+}
+
+
+/**
+ * Read an array of values, prefixed by its size, from a binary stream.
+ * @param a values read (updated, resized)
+ * @param s input stream
+ * @param NMAX maximum number of values expected
+ * @returns success?
+ * @note The size is checked against the bytes left in the stream before
+ * allocating, so that a corrupt size fails the read instead.
+ */
+template <class T>
+inline bool readBinaryValuesW(vector<T>& a, istream& s, size_t NMAX=SIZE_MAX) {
+  uint64_t N = 0;
+  if (!readBinaryValueW(N, s)) return false;
+  if (N>NMAX || N>readBinaryBytesLeft(s)/sizeof(T)) return false;
+  a.resize(N);
+  return N==0 || bool(s.read((char*) a.data(), N * sizeof(T)));
+}
+
+
+/**
+ * Read an array of values, prefixed by its size, from a binary stream into an existing buffer.
+ * @param a buffer to read values into (updated, must have enough space)
+ * @param s input stream
+ * @param N maximum number of values that fit in the buffer
+ * @returns number of values read, or size_t(-1) on failure
+ */
+template <class T>
+inline size_t readBinaryValuesW(T *a, istream& s, size_t N) {
+  uint64_t n = 0;
+  if (!readBinaryValueW(n, s) || n>N) return size_t(-1);
+  if (n>0 && !s.read((char*) a, n * sizeof(T))) return size_t(-1);
+  return n;
+}
+
+
+/**
+ * Read and validate header of a binary file.
+ * @param s input stream
+ * @param kind expected kind of data stored
+ * @param keySize expected size of key type in bytes
+ * @param valueSize expected size of value/weight type in bytes
+ * @param offsetSize expected size of offset type in bytes
+ * @returns is header valid?
+ */
+inline bool readBinaryHeader(istream& s, BinaryKind kind, size_t keySize, size_t valueSize, size_t offsetSize=0) {
+  BinaryHeader h;
+  if (!readBinaryValueW(h, s)) return false;
+  return h.magic==BINARY_MAGIC && h.version==BINARY_VERSION && h.kind==kind
+      && h.keySize==keySize && h.valueSize==valueSize && h.offsetSize==offsetSize;
+}
+
+
+/**
+ * Read the body of a CSR graph from a binary stream (no header).
+ * @param a output graph in CSR format (updated)
+ * @param s input stream
+ * @returns success? (fails if the fingerprint does not match, i.e., the file is corrupt)
+ */
+template <class K, class V, class E, class O>
+inline bool readBinaryCsrBodyW(DiGraphCsr<K, V, E, O>& a, istream& s) {
+  uint64_t h = 0;
+  if (!readBinaryValuesW(a.offsets, s) || a.offsets.empty()) return false;
+  if (!readBinaryValuesW(a.degrees, s)) return false;
+  if (!readBinaryValuesW(a.edgeKeys,   s)) return false;
+  if (!readBinaryValuesW(a.edgeValues, s)) return false;
+  if (!readBinaryValueW(h, s)) return false;
+  a.values.resize(a.degrees.size());
+  if (a.offsets.size() != a.degrees.size()+1 || a.edgeKeys.size() != a.edgeValues.size()) return false;
+  return h == binaryCsrFingerprint(a, a.degrees.size(), a.edgeKeys.size());
+}
+
+
+/**
+ * Read a CSR graph from a binary stream.
+ * @param a output graph in CSR format (updated)
+ * @param s input stream
+ * @returns success?
+ */
+template <class K, class V, class E, class O>
+inline bool readBinaryCsrW(DiGraphCsr<K, V, E, O>& a, istream& s) {
+  if (!readBinaryHeader(s, BINARY_CSR, sizeof(K), sizeof(E), sizeof(O))) return false;
+  return readBinaryCsrBodyW(a, s);
+}
+template <class K, class V, class E, class O>
+inline bool readBinaryCsrW(DiGraphCsr<K, V, E, O>& a, const char *pth) {
+  ifstream s(pth, std::ios::binary);
+  return readBinaryCsrW(a, s);
+}
+#pragma endregion
+#pragma endregion
@@ -0,0 +1,162 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unistd.h>
+#include "_main.hxx"
+#include "binary.hxx"
+#include "fingerprint.hxx"
+#include "louvain.hxx"
+
+using std::string;
+using std::vector;
+using std::ifstream;
+using std::ofstream;
+
+
+
+
+#pragma region CONFIGURATION
+/** Version of cached results, bumped whenever a change to the algorithm changes its results. */
+#define LOUVAIN_CACHE_VERSION 1u
+#pragma endregion
+
+
+
+
+#pragma region METHODS
+#pragma region KEY
+/**
+ * Obtain a hash of the options that affect the result of Louvain algorithm.
+ * @param o louvain options
+ * @returns 64-bit hash (repeat is left out, as it only affects timing)
+ */
+inline uint64_t louvainOptionsHash(const LouvainOptions& o) noexcept {
+  uint64_t h = LOUVAIN_CACHE_VERSION;
+  h = fingerprintStep(h, fingerprintBits(o.resolution));
+  h = fingerprintStep(h, fingerprintBits(o.tolerance));
+  h = fingerprintStep(h, fingerprintBits(o.aggregationTolerance));
+  h = fingerprintStep(h, fingerprintBits(o.toleranceDrop));
+  h = fingerprintStep(h, uint64_t(o.maxIterations));
+  h = fingerprintStep(h, uint64_t(o.maxPasses));
+  h = fingerprintStep(h, uint64_t(o.asynchronous));
+  h = fingerprintStep(h, uint64_t(o.pruningThreshold));
+  h = fingerprintStep(h, uint64_t(o.samplingDegree));
+  h = fingerprintStep(h, fingerprintBits(o.samplingMargin));
+  return fingerprintMix(h);
+}
+
+
+/**
+ * Get the path of a cached result.
+ * @param dir cache directory
+ * @param fp fingerprint of graph (see graphFingerprintOmp)
+ * @param o louvain options
+ * @returns path, as "<dir>/<fingerprint>-<options hash>.louvain"
+ */
+inline string louvainCachePath(const char *dir, uint64_t fp, const LouvainOptions& o) {
+  char name[64];
+  snprintf(name, sizeof(name), "/%016llx-%016llx.louvain", (unsigned long long) fp, (unsigned long long) louvainOptionsHash(o));
+  return string(dir) + name;
+}
+#pragma endregion
+
+
+
+
+#pragma region READ WRITE
+/**
+ * Write a result of Louvain algorithm to the cache.
+ * @param dir cache directory (must exist)
+ * @param fp fingerprint of graph
+ * @param o louvain options
+ * @param x louvain result
+ * @returns success?
+ * @note The result is written to a temporary file and then renamed, so that
+ * concurrent runs never see a partial entry.
+ */
+template <class K, class W>
+inline bool writeLouvainCache(const char *dir, uint64_t fp, const LouvainOptions& o, const LouvainResult<K, W>& x) {
+  string pth = louvainCachePath(dir, fp, o);
+  string tmp = pth + ".tmp" + std::to_string(getpid());
+  {
+    ofstream a(tmp, std::ios::binary);
+    if (!a) return false;
+    writeBinaryHeader(a, BINARY_LOUVAIN_RESULT, sizeof(K), sizeof(W));
+    writeBinaryValue(a, uint32_t(LOUVAIN_CACHE_VERSION));
+    writeBinaryValue(a, fp);
+    writeBinaryValue(a, louvainOptionsHash(o));
+    writeBinaryValue(a, int32_t(x.iterations));
+    writeBinaryValue(a, int32_t(x.passes));
+    writeBinaryValues(a, x.membership);
+    writeBinaryValues(a, x.vertexWeight);
+    writeBinaryValues(a, x.communityWeight);
+    writeBinaryValue(a, binaryFingerprint(x.membership.data(), x.membership.size()));
+    if (!a.flush()) { remove(tmp.c_str()); return false; }
+  }
+  if (rename(tmp.c_str(), pth.c_str())==0) return true;
+  remove(tmp.c_str());
+  return false;
+}
+
+
+/**
+ * Read a result of Louvain algorithm from the cache.
+ * @param a louvain result (updated; timings are left untouched)
+ * @param dir cache directory
+ * @param fp fingerprint of graph
+ * @param o louvain options
+ * @param S span of graph (expected size of membership)
+ * @returns was a valid entry found?
+ */
+template <class K, class W>
+inline bool readLouvainCacheW(LouvainResult<K, W>& a, const char *dir, uint64_t fp, const LouvainOptions& o, size_t S) {
+  ifstream s(louvainCachePath(dir, fp, o), std::ios::binary);
+  uint32_t v = 0; uint64_t f = 0, h = 0, c = 0; int32_t l = 0, p = 0;
+  if (!s || !readBinaryHeader(s, BINARY_LOUVAIN_RESULT, sizeof(K), sizeof(W))) return false;
+  if (!readBinaryValueW(v, s) || v!=LOUVAIN_CACHE_VERSION) return false;
+  if (!readBinaryValueW(f, s) || f!=fp) return false;
+  if (!readBinaryValueW(h, s) || h!=louvainOptionsHash(o)) return false;
+  if (!readBinaryValueW(l, s) || !readBinaryValueW(p, s)) return false;
+  if (!readBinaryValuesW(a.membership, s, S) || a.membership.size()!=S) return false;
+  if (!readBinaryValuesW(a.vertexWeight, s, S))    return false;
+  if (!readBinaryValuesW(a.communityWeight, s, S)) return false;
+  if (!readBinaryValueW(c, s) || c!=binaryFingerprint(a.membership.data(), S)) return false;
+  a.iterations = l;
+  a.passes     = p;
+  return true;
+}
+#pragma endregion
+
+
+
+
+#pragma region STATIC APPROACH
+#ifdef OPENMP
+/**
+ * Obtain the community membership of each vertex with Static Louvain, reusing a cached result if there is one.
+ * @param hit was the result found in the cache? (updated)
+ * @param x original graph
+ * @param fp fingerprint of graph (see graphFingerprintOmp)
+ * @param o louvain options
+ * @param dir cache directory
+ * @returns louvain result (on a hit, time is that of the lookup, and other timings are zero)
+ * @note On a miss, the result is computed and stored for later runs. Failing
+ * to store it is not an error.
+ */
+template <class G>
+inline auto louvainStaticOmpCachedW(bool& hit, const G& x, uint64_t fp, const LouvainOptions& o, const char *dir) {
+  using K = typename G::key_type;
+  using W = LOUVAIN_WEIGHT_TYPE;
+  LouvainResult<K, W> a({}, {}, {});
+  float t = measureDuration([&]() { hit = readLouvainCacheW(a, dir, fp, o, x.span()); });
+  if (hit) { a.time = t; a.totalWeight = sumValuesOmp(a.vertexWeight, 0.0)/2; return a; }
+  a = louvainStaticOmp(x, o);
+  writeLouvainCache(dir, fp, o, a);
+  return a;
+}
+#endif
+#pragma endregion
+#pragma endregion
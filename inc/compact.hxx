@@ -0,0 +1,94 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include "_main.hxx"
+#include "Graph.hxx"
+#include "update.hxx"
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+using std::vector;
+using std::move;
+
+
+
+
+#pragma region METHODS
+#pragma region COMPACT GRAPH
+/**
+ * Renumber the vertices of a graph to dense ids, preserving their order.
+ * @param a output graph with dense vertex ids (updated)
+ * @param ks original vertex id of each new vertex id (updated)
+ * @param x input graph
+ */
+template <class H, class G, class K>
+inline void compactGraphW(H& a, vector<K>& ks, const G& x) {
+  vector<K> ids(x.span());
+  ks.clear();
+  x.forEachVertexKey([&](auto u) { ids[u] = K(ks.size()); ks.push_back(K(u)); });
+  a.respan(ks.size());
+  x.forEachVertex([&](auto u, auto d) { a.addVertex(ids[u], d); });
+  x.forEachVertexKey([&](auto u) {
+    x.forEachEdge(u, [&](auto v, auto w) { a.addEdge(ids[u], ids[v], w); });
+  });
+  a.update();
+}
+
+/**
+ * Renumber the vertices of a graph to dense ids, preserving their order.
+ * @param ks original vertex id of each new vertex id (updated)
+ * @param x input graph
+ * @returns graph with dense vertex ids
+ */
+template <class G, class K>
+inline auto compactGraph(vector<K>& ks, const G& x) {
+  G a; compactGraphW(a, ks, x);
+  return DenseGraph<G>(move(a));
+}
+
+
+#ifdef OPENMP
+/**
+ * Renumber the vertices of a graph to dense ids in parallel, preserving their order.
+ * @param a output graph with dense vertex ids (updated)
+ * @param ks original vertex id of each new vertex id (updated)
+ * @param x input graph
+ */
+template <class H, class G, class K>
+inline void compactGraphOmpW(H& a, vector<K>& ks, const G& x) {
+  size_t S = x.span();
+  vector<K> ids(S), bufk(omp_get_max_threads());
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t u=0; u<S; ++u)
+    ids[u] = x.hasVertex(K(u))? K(1) : K();
+  size_t N = exclusiveScanOmpW(ids.data(), bufk.data(), ids.data(), S);
+  ks.resize(N);
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t u=0; u<S; ++u)
+    if (x.hasVertex(K(u))) ks[ids[u]] = K(u);
+  a.respan(N);
+  x.forEachVertex([&](auto u, auto d) { a.addVertex(ids[u], d); });
+  #pragma omp parallel
+  {
+    x.forEachVertexKey([&](auto u) {
+      x.forEachEdge(u, [&](auto v, auto w) { addEdgeOmpU(a, ids[u], ids[v], w); });
+    });
+  }
+  updateOmpU(a);
+}
+
+/**
+ * Renumber the vertices of a graph to dense ids in parallel, preserving their order.
+ * @param ks original vertex id of each new vertex id (updated)
+ * @param x input graph
+ * @returns graph with dense vertex ids
+ */
+template <class G, class K>
+inline auto compactGraphOmp(vector<K>& ks, const G& x) {
+  G a; compactGraphOmpW(a, ks, x);
+  return DenseGraph<G>(move(a));
+}
+#endif
+#pragma endregion
+#pragma endregion
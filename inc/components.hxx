@@ -0,0 +1,93 @@
+#pragma once
+#include <vector>
+#ifdef OPENMP
+#include <omp.h>
+#endif
+#include "_main.hxx"
+
+using std::vector;
+using std::swap;
+
+
+
+
+#ifdef OPENMP
+#pragma region METHODS
+#pragma region UNION-FIND
+/**
+ * Find the root of a vertex in a union-find forest, halving its path.
+ * @param parent parent of each vertex (updated)
+ * @param u vertex id
+ * @returns root vertex id
+ * @note Parents only ever move closer to the root, so concurrent halving is safe.
+ */
+template <class K>
+inline K componentRootOmp(vector<K>& parent, K u) noexcept {
+  while (true) {
+    K p = __atomic_load_n(&parent[u], __ATOMIC_RELAXED);
+    if (p==u) return u;
+    K g = __atomic_load_n(&parent[p], __ATOMIC_RELAXED);
+    if (g!=p) __atomic_store_n(&parent[u], g, __ATOMIC_RELAXED);
+    u = g;
+  }
+}
+
+
+/**
+ * Join the trees of two vertices in a union-find forest.
+ * @param parent parent of each vertex (updated)
+ * @param u first vertex id
+ * @param v second vertex id
+ * @note The larger root is hooked under the smaller one (with CAS, retrying
+ * if another thread got there first), so each root is the smallest vertex id
+ * in its component.
+ */
+template <class K>
+inline void componentUnionOmp(vector<K>& parent, K u, K v) noexcept {
+  while (true) {
+    u = componentRootOmp(parent, u);
+    v = componentRootOmp(parent, v);
+    if (u==v) return;
+    if (u<v) swap(u, v);
+    K e = u;
+    if (__atomic_compare_exchange_n(&parent[u], &e, v, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return;
+  }
+}
+#pragma endregion
+
+
+
+
+#pragma region CONNECTED COMPONENTS
+/**
+ * Find the connected components of a graph, in parallel.
+ * @param a smallest vertex id in the component of each vertex (output)
+ * @param x original graph (symmetric)
+ * @returns number of components
+ * @note Each edge is joined once, from its larger end, with lock-free
+ * union-find. Vertex ids not in the graph are their own component, but are
+ * not counted.
+ */
+template <class G, class K>
+inline size_t connectedComponentsOmpW(vector<K>& a, const G& x) {
+  size_t S = x.span(), C = 0;
+  a.resize(S);
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t u=0; u<S; ++u)
+    a[u] = K(u);
+  #pragma omp parallel for schedule(dynamic, 2048)
+  for (size_t u=0; u<S; ++u) {
+    if (!hasVertex(x, K(u))) continue;
+    x.forEachEdgeKey(K(u), [&](auto v) { if (K(v)<K(u)) componentUnionOmp(a, K(u), K(v)); });
+  }
+  #pragma omp parallel for schedule(static, 2048) reduction(+:C)
+  for (size_t u=0; u<S; ++u) {
+    K r = componentRootOmp(a, K(u));
+    __atomic_store_n(&a[u], r, __ATOMIC_RELAXED);
+    if (r==K(u) && hasVertex(x, K(u))) ++C;
+  }
+  return C;
+}
+#pragma endregion
+#pragma endregion
+#endif
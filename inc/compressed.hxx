@@ -0,0 +1,527 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <deque>
+#include <string>
+#include <istream>
+#include <streambuf>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+
+
+
+#pragma region CONFIGURATION
+#ifndef GRAPH_GZIP
+/** Read gzip compressed graphs (link with -lz)? */
+#define GRAPH_GZIP 0
+#endif
+#ifndef GRAPH_ZSTD
+/** Read zstd compressed graphs (link with -lzstd)? */
+#define GRAPH_ZSTD 0
+#endif
+#ifndef DECOMPRESS_CHUNK
+/** Size of each decompressed chunk handed to the reader, in bytes. */
+#define DECOMPRESS_CHUNK size_t(4 << 20)
+#endif
+#ifndef DECOMPRESS_QUEUE
+/** Maximum number of decompressed chunks waiting to be read. */
+#define DECOMPRESS_QUEUE 16
+#endif
+#ifndef DECOMPRESS_THREADS
+/** Number of threads decompressing frames in parallel (0 for half of the OpenMP threads, leaving the rest to the reader). */
+#define DECOMPRESS_THREADS 0
+#endif
+#pragma endregion
+
+
+
+
+#if GRAPH_GZIP
+#include <zlib.h>
+#endif
+#if GRAPH_ZSTD
+#include <zstd.h>
+#endif
+
+using std::pair;
+using std::vector;
+using std::deque;
+using std::string;
+using std::istream;
+using std::streambuf;
+using std::thread;
+using std::mutex;
+using std::unique_lock;
+using std::condition_variable;
+using std::move;
+using std::min;
+using std::max;
+
+
+
+
+#pragma region TYPES
+/**
+ * Compression format of a file.
+ */
+enum CompressionKind {
+  /** Not compressed. */
+  COMPRESSION_NONE = 0,
+  /** Gzip, possibly with several members (e.g. BGZF). */
+  COMPRESSION_GZIP = 1,
+  /** Zstandard, possibly with several frames (e.g. pzstd). */
+  COMPRESSION_ZSTD = 2
+};
+#pragma endregion
+
+
+
+
+#pragma region METHODS
+#pragma region FORMAT
+/**
+ * Get the compression format of a file from its extension.
+ * @param pth path to file
+ * @returns compression format, and length of path without the extension
+ */
+inline pair<CompressionKind, size_t> compressionKind(const char *pth) {
+  size_t n = strlen(pth);
+  auto ends = [&](const char *e) { size_t m = strlen(e); return n>=m && strcmp(pth+n-m, e)==0; };
+  if (ends(".gz"))  return {COMPRESSION_GZIP, n-3};
+  if (ends(".zst")) return {COMPRESSION_ZSTD, n-4};
+  return {COMPRESSION_NONE, n};
+}
+
+
+/**
+ * Split gzip data into BGZF members, which can be decompressed independently.
+ * @param a start and size of each member (updated)
+ * @param x compressed data
+ * @param N size of compressed data
+ * @returns is the data made of BGZF members only?
+ * @note Ordinary gzip members do not record their size, so they cannot be
+ * found without decompressing.
+ */
+inline bool splitGzipMembers(vector<pair<size_t, size_t>>& a, const uint8_t *x, size_t N) {
+  a.clear();
+  for (size_t i=0; i<N;) {
+    // Header: ID1 ID2 CM FLG MTIME(4) XFL OS XLEN(2), then extra subfield BC with BSIZE.
+    if (N-i < 18 || x[i]!=0x1f || x[i+1]!=0x8b || x[i+2]!=8 || !(x[i+3] & 4)) return false;
+    if (x[i+12]!='B' || x[i+13]!='C' || x[i+14]!=2 || x[i+15]!=0) return false;
+    size_t B = size_t(x[i+16] | (x[i+17] << 8)) + 1;
+    if (B > N-i) return false;
+    a.push_back({i, B});
+    i += B;
+  }
+  return true;
+}
+
+
+#if GRAPH_ZSTD
+/**
+ * Split zstd data into frames, which can be decompressed independently.
+ * @param a start and size of each frame (updated)
+ * @param x compressed data
+ * @param N size of compressed data
+ * @returns are the frames valid?
+ */
+inline bool splitZstdFrames(vector<pair<size_t, size_t>>& a, const uint8_t *x, size_t N) {
+  a.clear();
+  for (size_t i=0; i<N;) {
+    size_t B = ZSTD_findFrameCompressedSize(x+i, N-i);
+    if (ZSTD_isError(B) || B==0) return false;
+    a.push_back({i, B});
+    i += B;
+  }
+  return true;
+}
+#endif
+#pragma endregion
+#pragma endregion
+
+
+
+
+#pragma region CLASSES
+/**
+ * Stream buffer which decompresses a gzip or zstd file on the fly.
+ * @note The file is mapped, not read into memory, and nothing is written to
+ * disk. A producer thread decompresses ahead of the reader, into a bounded
+ * queue of chunks. If the file is made of independent frames (BGZF gzip, or
+ * multi-frame zstd), batches of frames are decompressed in parallel;
+ * otherwise a single thread decompresses while the reader parses.
+ * Only BGZF members record their size, so other multi-member gzip files
+ * (e.g. from pigz, or concatenated .gz files) are decompressed by a single
+ * thread. While the buffer is open, the reader's (calling thread's) OpenMP
+ * team is shrunk by the producer's (see DECOMPRESS_THREADS), so that both can
+ * run at once without oversubscribing. It must be destroyed on the thread
+ * that created it, which then gets its team size back.
+ */
+class DecompressStreambuf : public streambuf {
+  #pragma region DATA
+  protected:
+  /** Compression format. */
+  CompressionKind kind = COMPRESSION_NONE;
+  /** Mapped compressed file. */
+  const uint8_t *data = nullptr;
+  /** Size of compressed file. */
+  size_t size = 0;
+  /** Start and size of independent frames, if they could be found. */
+  vector<pair<size_t, size_t>> frames;
+  /** Number of threads to decompress frames with (see DECOMPRESS_THREADS). */
+  int threads = 1;
+  /** Team size of the reader before it was shrunk, or 0 if not shrunk. */
+  int readerThreads = 0;
+  /** Decompressed chunks, ready to be read. */
+  deque<vector<char>> ready;
+  /** Chunk being read. */
+  vector<char> current;
+  /** Lock for the queue. */
+  mutex lock;
+  /** Signalled when the queue changes. */
+  condition_variable changed;
+  /** Has the producer finished? */
+  bool done = false;
+  /** Did decompression fail? */
+  bool failed = false;
+  /** Has the reader gone away? */
+  bool stopped = false;
+  /** Thread decompressing ahead of the reader. */
+  thread producer;
+  /** Buffer size for decompressing a single frame (frames are usually small). */
+  static constexpr size_t FRAME_BUFFER = size_t(256 << 10);
+  #pragma endregion
+
+
+  #pragma region METHODS
+  #pragma region PROPERTIES
+  public:
+  /**
+   * Check if the file could be opened.
+   * @returns is open?
+   */
+  inline bool isOpen() const noexcept {
+    return data!=nullptr;
+  }
+
+  /**
+   * Check if decompression failed (valid once the stream is exhausted).
+   * @returns has failed?
+   */
+  inline bool hasFailed() const noexcept {
+    return failed;
+  }
+
+  /**
+   * Get the number of independent frames decompressed in parallel.
+   * @returns number of frames, or 0 if decompressed by a single thread
+   */
+  inline size_t parallelFrames() const noexcept {
+    return frames.size() > 1? frames.size() : 0;
+  }
+  #pragma endregion
+
+
+  #pragma region PRODUCE
+  protected:
+  /**
+   * Hand a decompressed chunk to the reader, waiting if the queue is full.
+   * @param x decompressed chunk (moved)
+   * @returns is the reader still there?
+   */
+  inline bool push(vector<char>&& x) {
+    if (x.empty()) return !stopped;
+    unique_lock<mutex> l(lock);
+    changed.wait(l, [&]() { return ready.size() < DECOMPRESS_QUEUE || stopped; });
+    if (stopped) return false;
+    ready.push_back(move(x));
+    changed.notify_all();
+    return true;
+  }
+
+  /**
+   * Mark the end of decompressed data.
+   * @param ok did decompression succeed?
+   */
+  inline void finish(bool ok) {
+    unique_lock<mutex> l(lock);
+    done   = true;
+    failed = !ok;
+    changed.notify_all();
+  }
+
+  /**
+   * Decompress a frame (or member) completely.
+   * @param a decompressed data (appended)
+   * @param x compressed frame
+   * @param N size of compressed frame
+   * @returns success?
+   */
+  inline bool decompressFrame(vector<char>& a, const uint8_t *x, size_t N) {
+    bool ok = false;
+    #if GRAPH_GZIP || GRAPH_ZSTD
+    auto fw = [&](const char *p, size_t n) { a.insert(a.end(), p, p+n); return true; };
+    #else
+    (void) a; (void) x; (void) N;
+    #endif
+    #if GRAPH_GZIP
+    if (kind==COMPRESSION_GZIP) ok = inflateStream(x, N, fw, FRAME_BUFFER);
+    #endif
+    #if GRAPH_ZSTD
+    if (kind==COMPRESSION_ZSTD) ok = decompressZstdStream(x, N, fw, FRAME_BUFFER);
+    #endif
+    return ok;
+  }
+
+  #if GRAPH_GZIP
+  /**
+   * Decompress gzip data (of one or more members) chunk by chunk.
+   * @param x compressed data
+   * @param N size of compressed data
+   * @param fw write a decompressed chunk (data, size), returning whether to continue
+   * @param B size of decompressed chunks
+   * @returns success?
+   */
+  template <class FW>
+  inline bool inflateStream(const uint8_t *x, size_t N, FW fw, size_t B=DECOMPRESS_CHUNK) {
+    vector<char> buf(B);
+    z_stream z = {};
+    if (inflateInit2(&z, 16 + MAX_WBITS)!=Z_OK) return false;
+    bool ok = true, open = false;
+    for (size_t i=0; i<N && ok;) {
+      size_t n = min(N-i, size_t(1) << 30);
+      z.next_in  = (Bytef*) (x+i);
+      z.avail_in = uInt(n);
+      // Keep going while there is input, or output left to flush.
+      do {
+        z.next_out  = (Bytef*) buf.data();
+        z.avail_out = uInt(buf.size());
+        int r = inflate(&z, Z_NO_FLUSH);
+        if (r!=Z_OK && r!=Z_STREAM_END && r!=Z_BUF_ERROR) { ok = false; break; }
+        if (!fw(buf.data(), buf.size() - z.avail_out)) { ok = false; break; }
+        // Concatenated members are decompressed one after another.
+        if (r==Z_STREAM_END) { inflateReset(&z); open = false; }
+        else if (r==Z_OK) open = true;
+        else { ok = z.avail_in==0; break; }
+      } while (z.avail_in>0 || z.avail_out==0);
+      i += n - z.avail_in;
+    }
+    inflateEnd(&z);
+    // A member left open means the data was truncated.
+    return ok && !open;
+  }
+  #endif
+
+  #if GRAPH_ZSTD
+  /**
+   * Decompress zstd data (of one or more frames) chunk by chunk.
+   * @param x compressed data
+   * @param N size of compressed data
+   * @param fw write a decompressed chunk (data, size), returning whether to continue
+   * @param B size of decompressed chunks
+   * @returns success?
+   */
+  template <class FW>
+  inline bool decompressZstdStream(const uint8_t *x, size_t N, FW fw, size_t B=DECOMPRESS_CHUNK) {
+    vector<char> buf(B);
+    ZSTD_DStream *z = ZSTD_createDStream();
+    if (!z) return false;
+    ZSTD_inBuffer  in  = {x, N, 0};
+    ZSTD_outBuffer out = {buf.data(), buf.size(), 0};
+    bool ok = true;
+    size_t r = 0;
+    // Keep going while there is input, or output left to flush.
+    while (ok && (in.pos < in.size || out.pos==out.size)) {
+      size_t i = in.pos;
+      out.pos  = 0;
+      r = ZSTD_decompressStream(z, &out, &in);
+      if (ZSTD_isError(r) || !fw(buf.data(), out.pos)) ok = false;
+      else if (in.pos==i && out.pos==0) { ok = in.pos==in.size; break; }
+    }
+    ZSTD_freeDStream(z);
+    // A frame left incomplete means the data was truncated.
+    return ok && r==0;
+  }
+  #endif
+
+  /**
+   * Decompress the whole file, handing chunks to the reader.
+   */
+  inline void produce() {
+    bool ok = true;
+    size_t F = frames.size();
+    if (F > 1) {
+      // Group frames into about a chunk of compressed data each, and decompress a batch of groups in parallel.
+      vector<size_t> groups = {0};
+      for (size_t f=0, b=0; f<F; ++f) {
+        b += frames[f].second;
+        if (b >= DECOMPRESS_CHUNK/4 || f+1==F) { groups.push_back(f+1); b = 0; }
+      }
+      size_t GN = groups.size() - 1;
+      vector<vector<char>> outs(threads);
+      vector<char> oks(threads);
+      for (size_t g=0; g<GN && ok; g+=threads) {
+        int T = int(min(size_t(threads), GN-g));
+        #pragma omp parallel for schedule(dynamic, 1) num_threads(T)
+        for (int t=0; t<T; ++t) {
+          outs[t].clear();
+          oks[t] = true;
+          for (size_t f=groups[g+t]; f<groups[g+t+1] && oks[t]; ++f)
+            oks[t] = decompressFrame(outs[t], data + frames[f].first, frames[f].second);
+        }
+        for (int t=0; t<T && ok; ++t)
+          ok = oks[t] && push(move(outs[t]));
+      }
+    }
+    else {
+      ok = false;
+      #if GRAPH_GZIP || GRAPH_ZSTD
+      auto fw = [&](const char *p, size_t n) { return push(vector<char>(p, p+n)); };
+      #endif
+      #if GRAPH_GZIP
+      if (kind==COMPRESSION_GZIP) ok = inflateStream(data, size, fw);
+      #endif
+      #if GRAPH_ZSTD
+      if (kind==COMPRESSION_ZSTD) ok = decompressZstdStream(data, size, fw);
+      #endif
+    }
+    finish(ok);
+  }
+  #pragma endregion
+
+
+  #pragma region CONSUME
+  protected:
+  /**
+   * Obtain the next decompressed chunk.
+   * @returns first character of chunk, or EOF
+   */
+  int_type underflow() override {
+    if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+    unique_lock<mutex> l(lock);
+    changed.wait(l, [&]() { return !ready.empty() || done; });
+    if (ready.empty()) return traits_type::eof();
+    current = move(ready.front());
+    ready.pop_front();
+    changed.notify_all();
+    setg(current.data(), current.data(), current.data() + current.size());
+    return traits_type::to_int_type(*gptr());
+  }
+  #pragma endregion
+  #pragma endregion
+
+
+  #pragma region CONSTRUCTORS
+  public:
+  /**
+   * Open a compressed file for decompression.
+   * @param pth path to file (.gz or .zst)
+   * @note Check isOpen() for success. Formats not enabled at build time (see
+   * GRAPH_GZIP and GRAPH_ZSTD) fail to open.
+   */
+  DecompressStreambuf(const char *pth) {
+    kind = compressionKind(pth).first;
+    if (kind==COMPRESSION_GZIP && !GRAPH_GZIP) return;
+    if (kind==COMPRESSION_ZSTD && !GRAPH_ZSTD) return;
+    if (kind==COMPRESSION_NONE) return;
+    int fd = open(pth, O_RDONLY);
+    if (fd<0) return;
+    struct stat st;
+    void *p = fstat(fd, &st)==0 && st.st_size>0? mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (p==MAP_FAILED) return;
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    data = (const uint8_t*) p;
+    size = st.st_size;
+    #ifdef OPENMP
+    threads = DECOMPRESS_THREADS>0? DECOMPRESS_THREADS : max(omp_get_max_threads()/2, 1);
+    #endif
+    if (kind==COMPRESSION_GZIP && !splitGzipMembers(frames, data, size)) frames.clear();
+    #if GRAPH_ZSTD
+    if (kind==COMPRESSION_ZSTD && !splitZstdFrames(frames, data, size)) frames.clear();
+    #endif
+    #ifdef OPENMP
+    readerThreads = omp_get_max_threads();
+    omp_set_num_threads(max(readerThreads - (frames.size()>1? threads : 1), 1));
+    #endif
+    producer = thread([this]() { produce(); });
+  }
+
+  ~DecompressStreambuf() {
+    {
+      unique_lock<mutex> l(lock);
+      stopped = true;
+      changed.notify_all();
+    }
+    if (producer.joinable()) producer.join();
+    if (data) munmap((void*) data, size);
+    #ifdef OPENMP
+    if (readerThreads>0) omp_set_num_threads(readerThreads);
+    #endif
+  }
+
+  DecompressStreambuf(const DecompressStreambuf&) = delete;
+  DecompressStreambuf& operator=(const DecompressStreambuf&) = delete;
+  #pragma endregion
+};
+
+
+
+
+/**
+ * Input stream which decompresses a gzip or zstd file on the fly.
+ * @note See DecompressStreambuf.
+ */
+class DecompressStream : public istream {
+  #pragma region DATA
+  protected:
+  /** Decompressing stream buffer. */
+  DecompressStreambuf buf;
+  #pragma endregion
+
+
+  #pragma region METHODS
+  public:
+  /**
+   * Get the number of independent frames decompressed in parallel.
+   * @returns number of frames, or 0 if decompressed by a single thread
+   */
+  inline size_t parallelFrames() const noexcept {
+    return buf.parallelFrames();
+  }
+
+  /**
+   * Check if decompression failed (valid once the stream is exhausted).
+   * @returns has failed?
+   */
+  inline bool hasFailed() const noexcept {
+    return buf.hasFailed();
+  }
+  #pragma endregion
+
+
+  #pragma region CONSTRUCTORS
+  public:
+  /**
+   * Open a compressed file for decompression.
+   * @param pth path to file (.gz or .zst)
+   */
+  DecompressStream(const char *pth) : istream(nullptr), buf(pth) {
+    rdbuf(&buf);
+    if (!buf.isOpen()) setstate(std::ios::failbit);
+  }
+  #pragma endregion
+};
+#pragma endregion
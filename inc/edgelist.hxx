@@ -0,0 +1,335 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <istream>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include "_main.hxx"
+#include "Graph.hxx"
+#include "update.hxx"
+#include "mtx.hxx"
+#include "compressed.hxx"
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+using std::string;
+using std::vector;
+using std::istream;
+using std::istringstream;
+using std::ifstream;
+using std::min;
+using std::max;
+using std::getline;
+
+
+
+
+#ifdef OPENMP
+#pragma region METHODS
+#pragma region READ SNAP
+/**
+ * Read contents of a SNAP edge list, with one "u v [w]" edge per line.
+ * @param s input stream
+ * @param weighted is it weighted?
+ * @param fc on chunk, before its edges are notified (1 + largest vertex id in the chunk)
+ * @param fb on edge (u, v, w), called only on the thread owning u (see belongsOmp)
+ * @returns number of bytes read
+ * @note Lines starting with '#' or '%' are comments. Vertex ids are kept as
+ * is, so they usually start at 0.
+ */
+template <class FC, class FB>
+inline size_t readSnapDoOmp(istream& s, bool weighted, FC fc, FB fb) {
+  auto fp = [&](size_t i, const char *line, auto fr) {
+    size_t u, v; double w;
+    if (parseEdgeLine(line, weighted, u, v, w)) fr(u, v, w);
+  };
+  return readEdgeLinesDoOmp(s, false, "#%", fp, fc, fb);
+}
+
+
+/**
+ * Read SNAP edge list as graph if test passes.
+ * @param a output graph (updated)
+ * @param s input stream
+ * @param weighted is it weighted?
+ * @param fv include vertex? (u, d)
+ * @param fe include edge? (u, v, w)
+ * @returns number of bytes read
+ * @note Every vertex id up to the largest one seen is added to the graph.
+ */
+template <class G, class FV, class FE>
+inline size_t readSnapIfOmpW(G& a, istream& s, bool weighted, FV fv, FE fe) {
+  using K = typename G::key_type;
+  using V = typename G::vertex_value_type;
+  using E = typename G::edge_value_type;
+  auto fc = [&](size_t n) { if (n > a.span()) addVerticesIfU(a, K(a.span()), K(n), V(), fv); };
+  auto fb = [&](auto u, auto v, auto w) { if (fe(K(u), K(v), K(w))) addEdgeOmpU(a, K(u), K(v), E(w)); };
+  size_t B = readSnapDoOmp(s, weighted, fc, fb);
+  updateOmpU(a);
+  return B;
+}
+
+
+/**
+ * Read SNAP edge list as graph.
+ * @param a output graph (updated)
+ * @param s input stream
+ * @param weighted is it weighted?
+ * @returns number of bytes read
+ */
+template <class G>
+inline size_t readSnapOmpW(G& a, istream& s, bool weighted=false) {
+  auto fv = [](auto u, auto d)         { return true; };
+  auto fe = [](auto u, auto v, auto w) { return true; };
+  return readSnapIfOmpW(a, s, weighted, fv, fe);
+}
+template <class G>
+inline size_t readSnapOmpW(G& a, const char *pth, bool weighted=false) {
+  ifstream s(pth);
+  return readSnapOmpW(a, s, weighted);
+}
+#pragma endregion
+
+
+
+
+#pragma region READ METIS
+/**
+ * Read header of METIS graph file, as "n m [fmt [ncon]]".
+ * @param s input stream
+ * @param n number of vertices (updated)
+ * @param m number of undirected edges (updated)
+ * @param fmt format digits, as vertex sizes, vertex weights, edge weights (updated)
+ * @param ncon number of vertex weights (updated)
+ * @returns is header valid?
+ */
+inline bool readMetisHeader(istream& s, size_t& n, size_t& m, string& fmt, size_t& ncon) {
+  string line;
+  while (getline(s, line))
+    if (!line.empty() && line[0]!='%') break;
+  istringstream sline(line);
+  n = 0; m = 0; fmt = "000"; ncon = 0;
+  if (!(sline >> n >> m)) return false;
+  if (sline >> fmt) fmt = string(3 - min(fmt.size(), size_t(3)), '0') + fmt;
+  if (!(sline >> ncon)) ncon = fmt[1]=='1'? 1 : 0;
+  return fmt.size()==3;
+}
+
+
+/**
+ * Read contents of a METIS graph file.
+ * @param s input stream
+ * @param fh on header (n, m, weighted)
+ * @param fb on edge (u, v, w), called only on the thread owning u (see belongsOmp)
+ * @returns number of bytes read in the body
+ * @note Line i after the header lists the neighbors of vertex i (from 1), each
+ * followed by its weight if the format has edge weights. Vertex sizes and
+ * weights are skipped. Each edge is listed in both directions in the file.
+ */
+template <class FH, class FB>
+inline size_t readMetisDoOmp(istream& s, FH fh, FB fb) {
+  size_t n, m, ncon; string fmt;
+  if (!readMetisHeader(s, n, m, fmt, ncon)) { fh(0, 0, false); return 0; }
+  bool   weighted = fmt[2]=='1';
+  size_t skip     = (fmt[0]=='1'? 1 : 0) + (fmt[1]=='1'? ncon : 0);
+  fh(n, m, weighted);
+  auto fp = [&](size_t i, const char *line, auto fr) {
+    char *p = (char*) line, *q = p;
+    size_t u = i+1;
+    if (u > n) return;
+    for (size_t j=0; j<skip; ++j, p=q)
+      strtod(p, &q);
+    while (true) {
+      size_t v = strtoull(p, &q, 10);
+      if (q==p) break;
+      p = q;
+      double w = weighted? strtod(p, &q) : 0; p = q;
+      fr(u, v, w? w : 1);
+    }
+  };
+  auto fc = [](size_t n) {};
+  return readEdgeLinesDoOmp(s, false, "%", fp, fc, fb);
+}
+
+
+/**
+ * Read METIS graph file as graph if test passes.
+ * @param a output graph (updated)
+ * @param s input stream
+ * @param fv include vertex? (u, d)
+ * @param fe include edge? (u, v, w)
+ * @returns number of bytes read in the body
+ */
+template <class G, class FV, class FE>
+inline size_t readMetisIfOmpW(G& a, istream& s, FV fv, FE fe) {
+  using K = typename G::key_type;
+  using V = typename G::vertex_value_type;
+  using E = typename G::edge_value_type;
+  auto fh = [&](auto n, auto m, auto weighted) { addVerticesIfU(a, K(1), K(n+1), V(), fv); };
+  auto fb = [&](auto u, auto v, auto w) { if (fe(K(u), K(v), K(w))) addEdgeOmpU(a, K(u), K(v), E(w)); };
+  size_t B = readMetisDoOmp(s, fh, fb);
+  updateOmpU(a);
+  return B;
+}
+
+
+/**
+ * Read METIS graph file as graph.
+ * @param a output graph (updated)
+ * @param s input stream
+ * @returns number of bytes read in the body
+ * @note Edge weights are read if the header says so.
+ */
+template <class G>
+inline size_t readMetisOmpW(G& a, istream& s) {
+  auto fv = [](auto u, auto d)         { return true; };
+  auto fe = [](auto u, auto v, auto w) { return true; };
+  return readMetisIfOmpW(a, s, fv, fe);
+}
+template <class G>
+inline size_t readMetisOmpW(G& a, const char *pth) {
+  ifstream s(pth);
+  return readMetisOmpW(a, s);
+}
+#pragma endregion
+
+
+
+
+#pragma region READ BINARY EDGES
+/**
+ * Read contents of a binary edge list, with (u32 u, u32 v[, f32 w]) records.
+ * @param s input stream
+ * @param weighted is it weighted?
+ * @param fc on chunk, before its edges are notified (1 + largest vertex id in the chunk)
+ * @param fb on edge (u, v, w), called only on the thread owning u (see belongsOmp)
+ * @returns number of bytes read, or 0 if the input ends in a partial record
+ * @note Records are in host byte order, and have no header or padding.
+ */
+template <class FC, class FB>
+inline size_t readBinaryEdgesDoOmp(istream& s, bool weighted, FC fc, FB fb) {
+  const size_t RECORDS = 131072;
+  const size_t R = weighted? 12 : 8;
+  vector<char> buf(RECORDS * R);
+  vector<tuple<size_t, size_t, double>> edges(RECORDS), routed;
+  vector<size_t> cnts;
+  size_t bytes = 0;
+  while (s) {
+    s.read(buf.data(), buf.size());
+    size_t E = size_t(s.gcount()) / R;
+    bytes += s.gcount();
+    if (size_t(s.gcount()) % R) return 0;
+    if (E==0) break;
+    #pragma omp parallel for schedule(static, 2048)
+    for (size_t i=0; i<E; ++i) {
+      const char *p = buf.data() + i*R;
+      uint32_t u, v; float w = 1;
+      memcpy(&u, p,   4);
+      memcpy(&v, p+4, 4);
+      if (weighted) memcpy(&w, p+8, 4);
+      edges[i] = {u, v, w? w : 1};
+    }
+    notifyEdgesOmp(routed, cnts, edges, E, false, fc, fb);
+  }
+  return bytes;
+}
+
+
+/**
+ * Read binary edge list as graph if test passes.
+ * @param a output graph (updated)
+ * @param s input stream
+ * @param weighted is it weighted?
+ * @param fv include vertex? (u, d)
+ * @param fe include edge? (u, v, w)
+ * @returns number of bytes read, or 0 if the input ends in a partial record
+ * @note Every vertex id up to the largest one seen is added to the graph.
+ */
+template <class G, class FV, class FE>
+inline size_t readBinaryEdgesIfOmpW(G& a, istream& s, bool weighted, FV fv, FE fe) {
+  using K = typename G::key_type;
+  using V = typename G::vertex_value_type;
+  using E = typename G::edge_value_type;
+  auto fc = [&](size_t n) { if (n > a.span()) addVerticesIfU(a, K(a.span()), K(n), V(), fv); };
+  auto fb = [&](auto u, auto v, auto w) { if (fe(K(u), K(v), K(w))) addEdgeOmpU(a, K(u), K(v), E(w)); };
+  size_t B = readBinaryEdgesDoOmp(s, weighted, fc, fb);
+  updateOmpU(a);
+  return B;
+}
+
+
+/**
+ * Read binary edge list as graph.
+ * @param a output graph (updated)
+ * @param s input stream
+ * @param weighted is it weighted?
+ * @returns number of bytes read, or 0 if the input ends in a partial record
+ */
+template <class G>
+inline size_t readBinaryEdgesOmpW(G& a, istream& s, bool weighted=false) {
+  auto fv = [](auto u, auto d)         { return true; };
+  auto fe = [](auto u, auto v, auto w) { return true; };
+  return readBinaryEdgesIfOmpW(a, s, weighted, fv, fe);
+}
+template <class G>
+inline size_t readBinaryEdgesOmpW(G& a, const char *pth, bool weighted=false) {
+  ifstream s(pth, std::ios::binary);
+  return readBinaryEdgesOmpW(a, s, weighted);
+}
+#pragma endregion
+
+
+
+
+#pragma region READ GRAPH
+/**
+ * Read a graph from a stream, picking the format from the file extension.
+ * @param a output graph (updated)
+ * @param s input stream
+ * @param e file extension, without the dot
+ * @param weighted is it weighted? (ignored for METIS, whose header says so)
+ * @returns number of bytes read
+ */
+template <class G>
+inline size_t readGraphOmpW(G& a, istream& s, const string& e, bool weighted=false) {
+  if (e=="mtx") return readMtxOmpW(a, s, weighted);
+  if (e=="graph" || e=="metis") return readMetisOmpW(a, s);
+  if (e=="bin"   || e=="bel")   return readBinaryEdgesOmpW(a, s, weighted);
+  return readSnapOmpW(a, s, weighted);
+}
+
+
+/**
+ * Read a graph file, picking the format from its extension.
+ * @param a output graph (updated)
+ * @param pth path to file (.mtx, .graph/.metis, .bin/.bel, or else a SNAP edge list), optionally compressed (.gz, .zst)
+ * @param weighted is it weighted? (ignored for METIS, whose header says so)
+ * @returns number of bytes read (decompressed), or 0 on failure
+ * @note Compressed files are decompressed on the fly, while being parsed (see
+ * DecompressStream).
+ */
+template <class G>
+inline size_t readGraphOmpW(G& a, const char *pth, bool weighted=false) {
+  auto [kind, n] = compressionKind(pth);
+  string p(pth, n);
+  size_t i = p.rfind('.');
+  size_t j = p.rfind('/');
+  string e = i!=string::npos && (j==string::npos || i>j)? p.substr(i+1) : "";
+  if (kind!=COMPRESSION_NONE) {
+    DecompressStream s(pth);
+    if (!s) return 0;
+    size_t B = readGraphOmpW(a, s, e, weighted);
+    return s.hasFailed()? 0 : B;
+  }
+  if (e=="mtx") return readMtxOmpW(a, pth, weighted);
+  if (e=="graph" || e=="metis") return readMetisOmpW(a, pth);
+  if (e=="bin"   || e=="bel")   return readBinaryEdgesOmpW(a, pth, weighted);
+  return readSnapOmpW(a, pth, weighted);
+}
+#pragma endregion
+#pragma endregion
+#endif
@@ -0,0 +1,176 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#ifdef OPENMP
+#include <omp.h>
+#endif
+#include "_main.hxx"
+
+using std::is_arithmetic;
+
+
+
+
+#pragma region CONFIGURATION
+/** Number of values hashed together by one thread, in an array fingerprint. */
+#define FINGERPRINT_BLOCK size_t(65536)
+#pragma endregion
+
+
+
+
+#pragma region METHODS
+#pragma region MIXING
+/**
+ * Scramble the bits of a 64-bit value (splitmix64 finalizer).
+ * @param x value
+ * @returns scrambled value
+ */
+inline uint64_t fingerprintMix(uint64_t x) noexcept {
+  x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27; x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return x;
+}
+
+
+/**
+ * Add a 64-bit word to a running hash.
+ * @param h running hash
+ * @param x word to add
+ * @returns updated hash
+ * @note This is a multiply-rotate step, which is cheap enough to keep up
+ * with a memory sweep.
+ */
+inline uint64_t fingerprintStep(uint64_t h, uint64_t x) noexcept {
+  x *= 0x87c37b91114253d5ull;
+  x  = (x << 31) | (x >> 33);
+  h ^= x * 0x4cf5ad432745937full;
+  return ((h << 27) | (h >> 37)) * 5 + 0x52dce729;
+}
+
+
+/**
+ * Get the bits of a value, as a 64-bit word.
+ * @param v value (at most 8 bytes; values of non-arithmetic types, like None, are ignored)
+ * @returns bits of value
+ */
+template <class T>
+inline uint64_t fingerprintBits(const T& v) noexcept {
+  uint64_t a = 0;
+  if constexpr (is_arithmetic<T>::value) memcpy(&a, &v, sizeof(T) < 8? sizeof(T) : 8);
+  return a;
+}
+#pragma endregion
+
+
+
+
+#pragma region ARRAY FINGERPRINT
+/**
+ * Hash a block of values.
+ * @param x values
+ * @param i begin index
+ * @param I end index
+ * @returns hash of block (depends on its position)
+ */
+template <class T>
+inline uint64_t fingerprintBlock(const T *x, size_t i, size_t I) noexcept {
+  uint64_t h = i;
+  for (; i<I; ++i)
+    h = fingerprintStep(h, fingerprintBits(x[i]));
+  return fingerprintMix(h);
+}
+
+
+/**
+ * Obtain the fingerprint of an array of values.
+ * @param x values
+ * @param N number of values
+ * @returns 64-bit fingerprint
+ */
+template <class T>
+inline uint64_t fingerprintValues(const T *x, size_t N) noexcept {
+  uint64_t a = 0;
+  for (size_t i=0; i<N; i+=FINGERPRINT_BLOCK)
+    a += fingerprintBlock(x, i, i+FINGERPRINT_BLOCK < N? i+FINGERPRINT_BLOCK : N);
+  return fingerprintMix(a ^ N);
+}
+
+
+#ifdef OPENMP
+/**
+ * Obtain the fingerprint of an array of values, in parallel.
+ * @param x values
+ * @param N number of values
+ * @returns 64-bit fingerprint (same as fingerprintValues)
+ * @note Blocks are hashed independently, and their hashes summed, so that
+ * threads need not wait on each other.
+ */
+template <class T>
+inline uint64_t fingerprintValuesOmp(const T *x, size_t N) noexcept {
+  uint64_t a = 0;
+  #pragma omp parallel for schedule(static) reduction(+:a)
+  for (size_t i=0; i<N; i+=FINGERPRINT_BLOCK)
+    a += fingerprintBlock(x, i, i+FINGERPRINT_BLOCK < N? i+FINGERPRINT_BLOCK : N);
+  return fingerprintMix(a ^ N);
+}
+#endif
+#pragma endregion
+
+
+
+
+#pragma region GRAPH FINGERPRINT
+/**
+ * Hash the out-edges of a vertex.
+ * @param x graph
+ * @param u vertex id
+ * @returns hash of vertex (depends on its id)
+ */
+template <class G, class K>
+inline uint64_t fingerprintVertex(const G& x, K u) noexcept {
+  uint64_t h = fingerprintStep(uint64_t(u), x.degree(u));
+  x.forEachEdge(u, [&](auto v, auto w) { h = fingerprintStep(h, uint64_t(v) ^ (fingerprintBits(w) << 32) ^ (fingerprintBits(w) >> 32)); });
+  return fingerprintMix(h);
+}
+
+
+/**
+ * Obtain the fingerprint of a graph, from its vertices, edges and edge weights.
+ * @param x graph
+ * @returns 64-bit fingerprint
+ * @note Edges are hashed in the order they are stored, so the same graph
+ * built in a different order has a different fingerprint.
+ */
+template <class G>
+inline uint64_t graphFingerprint(const G& x) noexcept {
+  using K = typename G::key_type;
+  size_t S = x.span();
+  uint64_t a = 0;
+  for (size_t u=0; u<S; ++u)
+    if (x.hasVertex(K(u))) a += fingerprintVertex(x, K(u));
+  return fingerprintMix(fingerprintStep(a, S) ^ x.size());
+}
+
+
+#ifdef OPENMP
+/**
+ * Obtain the fingerprint of a graph, in parallel.
+ * @param x graph
+ * @returns 64-bit fingerprint (same as graphFingerprint)
+ */
+template <class G>
+inline uint64_t graphFingerprintOmp(const G& x) noexcept {
+  using K = typename G::key_type;
+  size_t S = x.span();
+  uint64_t a = 0;
+  #pragma omp parallel for schedule(dynamic, 2048) reduction(+:a)
+  for (size_t u=0; u<S; ++u)
+    if (x.hasVertex(K(u))) a += fingerprintVertex(x, K(u));
+  return fingerprintMix(fingerprintStep(a, S) ^ x.size());
+}
+#endif
+#pragma endregion
+#pragma endregion
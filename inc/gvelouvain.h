@@ -0,0 +1,111 @@
+#ifndef GVELOUVAIN_H
+#define GVELOUVAIN_H
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+
+/** Version of the C API (incremented on incompatible changes). */
+#define GVE_LOUVAIN_API_VERSION 1
+
+/** Success. */
+#define GVE_LOUVAIN_OK           0
+/** A required argument is null or out of range, or the graph is malformed. */
+#define GVE_LOUVAIN_EINVAL     (-1)
+/** Out of memory while allocating the Louvain workspace. */
+#define GVE_LOUVAIN_ENOMEM     (-2)
+/** Unexpected internal failure. */
+#define GVE_LOUVAIN_EINTERNAL  (-3)
+
+
+/**
+ * Options for Louvain algorithm.
+ * @note Use gve_louvain_default_options() to initialize, then override fields.
+ */
+typedef struct gve_louvain_options {
+  /** Number of times to repeat the algorithm [1]. */
+  int32_t repeat;
+  /** Maximum number of iterations per pass [20]. */
+  int32_t max_iterations;
+  /** Maximum number of passes [10]. */
+  int32_t max_passes;
+  /** Padding (unused). */
+  int32_t padding;
+  /** Resolution parameter for modularity [1]. */
+  double resolution;
+  /** Tolerance for convergence [1e-2]. */
+  double tolerance;
+  /** Tolerance for aggregation [0.8]. */
+  double aggregation_tolerance;
+  /** Tolerance drop factor after each pass [10]. */
+  double tolerance_drop;
+} gve_louvain_options;
+
+
+/**
+ * Statistics of a Louvain run.
+ */
+typedef struct gve_louvain_stats {
+  /** Number of iterations performed. */
+  int32_t iterations;
+  /** Number of passes performed. */
+  int32_t passes;
+  /** Time spent in milliseconds. */
+  float time;
+  /** Time spent in milliseconds in local-moving phase. */
+  float local_move_time;
+  /** Time spent in milliseconds in aggregation phase. */
+  float aggregation_time;
+  /** Padding (unused). */
+  float padding;
+  /** Modularity of the communities obtained. */
+  double modularity;
+} gve_louvain_stats;
+
+
+/**
+ * Get the version of the C API implemented by the library.
+ * @returns GVE_LOUVAIN_API_VERSION of the library
+ */
+int gve_louvain_api_version(void);
+
+
+/**
+ * Initialize options for Louvain algorithm with default values.
+ * @param o options (updated)
+ */
+void gve_louvain_default_options(gve_louvain_options *o);
+
+
+/**
+ * Obtain the community membership of each vertex with Static Louvain.
+ * @param n number of vertices
+ * @param offsets offsets of the outgoing edges of each vertex (size n+1)
+ * @param edges target vertex ids of the outgoing edges (size offsets[n])
+ * @param weights edge weights (size offsets[n]), or null for unit weights
+ * @param o options, or null for defaults
+ * @param threads number of threads to use, or 0 for the OpenMP default
+ * @param membership community of each vertex (output, size n)
+ * @param stats statistics of the run (output), or null
+ * @returns GVE_LOUVAIN_OK on success, or a negative error code
+ * (GVE_LOUVAIN_EINVAL if offsets decrease, or a target id is not less than n)
+ * @note The graph must be symmetric (each undirected edge stored in both
+ * directions). Input arrays are used in place, and are not modified. The
+ * membership is written directly into the given buffer.
+ */
+int gve_louvain_static(
+  uint32_t n, const uint64_t *offsets, const uint32_t *edges, const float *weights,
+  const gve_louvain_options *o, int threads, uint32_t *membership, gve_louvain_stats *stats);
+
+
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -2,20 +2,47 @@
 #include <utility>
 #include <tuple>
 #include <vector>
+#include <deque>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <fstream>
+#include <thread>
+#include <cstdio>
+#include <cmath>
+#include <limits>
 #include <algorithm>
+#include <type_traits>
 #include "_main.hxx"
 #include "Graph.hxx"
 #include "properties.hxx"
 #include "csr.hxx"
+#include "binary.hxx"
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
 using std::tuple;
+using std::numeric_limits;
 using std::vector;
+using std::deque;
+using std::string;
+using std::istream;
+using std::ostream;
+using std::ifstream;
+using std::ofstream;
+using std::thread;
+using std::rename;
 using std::make_pair;
+using std::make_tuple;
+using std::tie;
 using std::move;
 using std::swap;
+using std::copy;
+using std::sort;
+using std::lower_bound;
+using std::enable_if_t;
+using std::is_lvalue_reference;
 using std::get;
 using std::min;
 using std::max;
@@ -43,6 +70,14 @@ struct LouvainOptions {
   int maxIterations;
   /** Maximum number of passes [10]. */
   int maxPasses;
+  /** Use queue-driven asynchronous local moving, instead of synchronous sweeps? [false] */
+  bool asynchronous;
+  /** Consecutive non-moves after which a vertex may be skipped, 0 to disable [0]. */
+  int pruningThreshold;
+  /** Degree above which a vertex scans only a sample of that many edges, 0 to disable [0]. */
+  int samplingDegree;
+  /** Gain margin, in standard errors, below which a sampled scan is redone exactly [3]. */
+  double samplingMargin;
   #pragma endregion
 
 
@@ -56,9 +91,13 @@ struct LouvainOptions {
    * @param toleranceDrop tolerance drop factor after each pass [10]
    * @param maxIterations maximum number of iterations per pass [20]
    * @param maxPasses maximum number of passes [10]
+   * @param asynchronous use queue-driven asynchronous local moving? [false]
+   * @param pruningThreshold consecutive non-moves after which a vertex may be skipped, 0 to disable [0]
+   * @param samplingDegree degree above which a vertex scans only a sample of that many edges, 0 to disable [0]
+   * @param samplingMargin gain margin, in standard errors, below which a sampled scan is redone exactly [3]
    */
-  LouvainOptions(int repeat=1, double resolution=1, double tolerance=1e-2, double aggregationTolerance=0.8, double toleranceDrop=10, int maxIterations=20, int maxPasses=10) :
-  repeat(repeat), resolution(resolution), tolerance(tolerance), aggregationTolerance(aggregationTolerance), toleranceDrop(toleranceDrop), maxIterations(maxIterations), maxPasses(maxPasses) {}
+  LouvainOptions(int repeat=1, double resolution=1, double tolerance=1e-2, double aggregationTolerance=0.8, double toleranceDrop=10, int maxIterations=20, int maxPasses=10, bool asynchronous=false, int pruningThreshold=0, int samplingDegree=0, double samplingMargin=3) :
+  repeat(repeat), resolution(resolution), tolerance(tolerance), aggregationTolerance(aggregationTolerance), toleranceDrop(toleranceDrop), maxIterations(maxIterations), maxPasses(maxPasses), asynchronous(asynchronous), pruningThreshold(pruningThreshold), samplingDegree(samplingDegree), samplingMargin(samplingMargin) {}
   #pragma endregion
 };
 
@@ -101,6 +140,14 @@ struct LouvainResult {
   float aggregationTime;
   /** Number of vertices initially marked as affected. */
   size_t affectedVertices;
+  /** Number of vertex scans skipped by pruning. */
+  size_t skippedScans;
+  /** Number of vertex scans done on a sample of edges. */
+  size_t sampledScans;
+  /** Number of sampled vertex scans that had to be redone exactly. */
+  size_t exactRescans;
+  /** Total edge weight of the original graph, counting each undirected edge once (M). */
+  double totalWeight;
   #pragma endregion
 
 
@@ -119,9 +166,13 @@ struct LouvainResult {
    * @param localMoveTime time spent in milliseconds in local-moving phase
    * @param aggregationTime time spent in milliseconds in aggregation phase
    * @param affectedVertices number of vertices initially marked as affected
+   * @param skippedScans number of vertex scans skipped by pruning
+   * @param sampledScans number of vertex scans done on a sample of edges
+   * @param exactRescans number of sampled vertex scans that had to be redone exactly
+   * @param totalWeight total edge weight of the original graph, counting each undirected edge once (M)
    */
-  LouvainResult(vector<K>&& membership, vector<W>&& vertexWeight, vector<W>&& communityWeight, int iterations=0, int passes=0, float time=0, float markingTime=0, float initializationTime=0, float firstPassTime=0, float localMoveTime=0, float aggregationTime=0, size_t affectedVertices=0) :
-  membership(membership), vertexWeight(vertexWeight), communityWeight(communityWeight), iterations(iterations), passes(passes), time(time), markingTime(markingTime), initializationTime(initializationTime), firstPassTime(firstPassTime), localMoveTime(localMoveTime), aggregationTime(aggregationTime), affectedVertices(affectedVertices) {}
+  LouvainResult(vector<K>&& membership, vector<W>&& vertexWeight, vector<W>&& communityWeight, int iterations=0, int passes=0, float time=0, float markingTime=0, float initializationTime=0, float firstPassTime=0, float localMoveTime=0, float aggregationTime=0, size_t affectedVertices=0, size_t skippedScans=0, size_t sampledScans=0, size_t exactRescans=0, double totalWeight=0) :
+  membership(membership), vertexWeight(vertexWeight), communityWeight(communityWeight), iterations(iterations), passes(passes), time(time), markingTime(markingTime), initializationTime(initializationTime), firstPassTime(firstPassTime), localMoveTime(localMoveTime), aggregationTime(aggregationTime), affectedVertices(affectedVertices), skippedScans(skippedScans), sampledScans(sampledScans), exactRescans(exactRescans), totalWeight(totalWeight) {}
 
 
   /**
@@ -138,9 +189,82 @@ struct LouvainResult {
    * @param localMoveTime time spent in milliseconds in local-moving phase
    * @param aggregationTime time spent in milliseconds in aggregation phase
    * @param affectedVertices number of vertices initially marked as affected
+   * @param skippedScans number of vertex scans skipped by pruning
+   * @param sampledScans number of vertex scans done on a sample of edges
+   * @param exactRescans number of sampled vertex scans that had to be redone exactly
+   * @param totalWeight total edge weight of the original graph, counting each undirected edge once (M)
    */
-  LouvainResult(vector<K>& membership, vector<W>& vertexWeight, vector<W>& communityWeight, int iterations=0, int passes=0, float time=0, float markingTime=0, float initializationTime=0, float firstPassTime=0, float localMoveTime=0, float aggregationTime=0, size_t affectedVertices=0) :
-  membership(move(membership)), vertexWeight(move(vertexWeight)), communityWeight(move(communityWeight)), iterations(iterations), passes(passes), time(time), markingTime(markingTime), initializationTime(initializationTime), firstPassTime(firstPassTime), localMoveTime(localMoveTime), aggregationTime(aggregationTime), affectedVertices(affectedVertices) {}
+  LouvainResult(vector<K>& membership, vector<W>& vertexWeight, vector<W>& communityWeight, int iterations=0, int passes=0, float time=0, float markingTime=0, float initializationTime=0, float firstPassTime=0, float localMoveTime=0, float aggregationTime=0, size_t affectedVertices=0, size_t skippedScans=0, size_t sampledScans=0, size_t exactRescans=0, double totalWeight=0) :
+  membership(move(membership)), vertexWeight(move(vertexWeight)), communityWeight(move(communityWeight)), iterations(iterations), passes(passes), time(time), markingTime(markingTime), initializationTime(initializationTime), firstPassTime(firstPassTime), localMoveTime(localMoveTime), aggregationTime(aggregationTime), affectedVertices(affectedVertices), skippedScans(skippedScans), sampledScans(sampledScans), exactRescans(exactRescans), totalWeight(totalWeight) {}
+  #pragma endregion
+};
+
+
+
+
+/**
+ * State of Louvain algorithm at the end of a pass, used to resume it later.
+ * @tparam K key type (vertex-id)
+ * @tparam W weight type
+ */
+template <class K, class W=LOUVAIN_WEIGHT_TYPE>
+struct LouvainCheckpoint {
+  #pragma region DATA
+  /** Community membership of each vertex in the original graph (vertex-id in aggregated graph). */
+  vector<K> membership;
+  /** Aggregated graph, input to the next pass. */
+  DiGraphCsr<K, None, W> graph;
+  /** Total edge weight of each vertex in the aggregated graph. */
+  vector<W> vertexWeight;
+  /** Total edge weight of each community in the aggregated graph. */
+  vector<W> communityWeight;
+  /** Tolerance for convergence in the next pass. */
+  double tolerance;
+  /** Number of iterations performed. */
+  int iterations;
+  /** Number of passes performed. */
+  int passes;
+  #pragma endregion
+
+
+  #pragma region CONSTRUCTORS
+  /**
+   * Empty state of Louvain algorithm.
+   */
+  LouvainCheckpoint() :
+  graph(0, 0), tolerance(0), iterations(0), passes(0) {}
+  #pragma endregion
+};
+
+
+
+
+/**
+ * Aggregated graph of the first pass of a dynamic run, kept for reuse in the next run.
+ * @tparam K key type (vertex-id)
+ * @tparam W weight type
+ * @note Later passes restart from singleton communities on the (small)
+ * aggregated graph, so only the first level, built over the input graph, is
+ * kept. Edge updates applied since it was built are recorded as signed deltas.
+ */
+template <class K, class W=LOUVAIN_WEIGHT_TYPE>
+struct LouvainHierarchy {
+  #pragma region DATA
+  /** Community of each vertex in the aggregated graph, or -1 if vertex does not exist (empty if none). */
+  vector<K> membership;
+  /** Aggregated graph, with no spare capacity. */
+  DiGraphCsr<K, None, W> graph;
+  /** Edge updates since the aggregated graph was built (negative weight for deletions). */
+  vector<tuple<K, K, W>> deltas;
+  #pragma endregion
+
+
+  #pragma region CONSTRUCTORS
+  /**
+   * Empty aggregated graph.
+   */
+  LouvainHierarchy() :
+  graph(0, 0) {}
   #pragma endregion
 };
 #pragma endregion
@@ -212,7 +336,7 @@ inline void louvainVertexWeightsOmpW(vector<W>& vtot, const G& x) {
   size_t S = x.span();
   #pragma omp parallel for schedule(dynamic, 2048)
   for (K u=0; u<S; ++u) {
-    if (!x.hasVertex(u)) continue;
+    if (!hasVertex(x, u)) continue;
     x.forEachEdge(u, [&](auto v, auto w) { vtot[u] += w; });
   }
 }
@@ -248,7 +372,7 @@ inline void louvainCommunityWeightsOmpW(vector<W>& ctot, const G& x, const vecto
   size_t S = x.span();
   #pragma omp parallel for schedule(static, 2048)
   for (K u=0; u<S; ++u) {
-    if (!x.hasVertex(u)) continue;
+    if (!hasVertex(x, u)) continue;
     K c = vcom[u];
     #pragma omp atomic
     ctot[c] += vtot[u];
@@ -286,11 +410,41 @@ inline void louvainInitializeOmpW(vector<K>& vcom, vector<W>& ctot, const G& x,
   size_t S = x.span();
   #pragma omp parallel for schedule(static, 2048)
   for (K u=0; u<S; ++u) {
-    if (!x.hasVertex(u)) continue;
+    if (!hasVertex(x, u)) continue;
     vcom[u] = u;
     ctot[u] = vtot[u];
   }
 }
+
+
+/**
+ * Find the total edge weight of each vertex, and initialize each vertex as
+ * its own (affected) community, in a single sweep.
+ * @param vcom community each vertex belongs to (updated)
+ * @param vtot total edge weight of each vertex (updated)
+ * @param ctot total edge weight of each community (updated)
+ * @param vaff is vertex affected flag (updated)
+ * @param x original graph
+ * @returns total edge weight of the graph (2M)
+ * @note All entries below span are written, so the buffers need not be reset.
+ */
+template <class G, class K, class W, class B>
+inline double louvainInitializeFusedOmpW(vector<K>& vcom, vector<W>& vtot, vector<W>& ctot, vector<B>& vaff, const G& x) {
+  size_t S = x.span();
+  double a = 0;
+  #pragma omp parallel for schedule(dynamic, 2048) reduction(+:a)
+  for (K u=0; u<S; ++u) {
+    bool ex = hasVertex(x, u);
+    W    d  = W();
+    if (ex) x.forEachEdge(u, [&](auto v, auto w) { d += w; });
+    vcom[u] = ex? u : K();
+    vtot[u] = d;
+    ctot[u] = d;
+    vaff[u] = B(1);
+    a += d;
+  }
+  return a;
+}
 #endif
 
 
@@ -326,7 +480,7 @@ inline void louvainInitializeFromOmpW(vector<K>& vcom, vector<W>& ctot, const G&
   size_t S = y.span();
   #pragma omp parallel for schedule(static, 2048)
   for (K u=0; u<S; ++u) {
-    if (!y.hasVertex(u)) continue;
+    if (!hasVertex(y, u)) continue;
     K c = q[u];
     vcom[u]  = c;
     #pragma omp atomic
@@ -585,7 +739,7 @@ inline int louvainMoveW(vector<K>& vcom, vector<W>& ctot, vector<B>& vaff, vecto
  * @returns iterations performed (0 if converged already)
  */
 template <class G, class K, class W, class B, class FC, class FA>
-inline int louvainMoveOmpW(vector<K>& vcom, vector<W>& ctot, vector<B>& vaff, vector<vector<K>*>& vcs, vector<vector<W>*>& vcout, const G& x, const vector<W>& vtot, double M, double R, int L, FC fc, FA fa) {
+CPU_CLONES inline int louvainMoveOmpW(vector<K>& vcom, vector<W>& ctot, vector<B>& vaff, vector<vector<K>*>& vcs, vector<vector<W>*>& vcout, const G& x, const vector<W>& vtot, double M, double R, int L, FC fc, FA fa) {
   size_t S = x.span();
   int l = 0;
   W  el = W();
@@ -594,7 +748,7 @@ inline int louvainMoveOmpW(vector<K>& vcom, vector<W>& ctot, vector<B>& vaff, ve
     #pragma omp parallel for schedule(dynamic, 2048) reduction(+:el)
     for (K u=0; u<S; ++u) {
       int t = omp_get_thread_num();
-      if (!x.hasVertex(u)) continue;
+      if (!hasVertex(x, u)) continue;
       if (!fa(u) || !vaff[u]) continue;
       louvainClearScanW(*vcs[t], *vcout[t]);
       louvainScanCommunitiesW(*vcs[t], *vcout[t], x, u, vcom);
@@ -629,150 +783,523 @@ inline int louvainMoveOmpW(vector<K>& vcom, vector<W>& ctot, vector<B>& vaff, ve
   auto fa = [](auto u) { return true; };
   return louvainMoveOmpW(vcom, ctot, vaff, vcs, vcout, x, vtot, M, R, L, fc, fa);
 }
-#endif
-#pragma endregion
 
 
+/**
+ * Hash a vertex and an iteration, to obtain a pseudo-random number.
+ * @param u given vertex
+ * @param l current iteration
+ * @returns hash of vertex and iteration
+ * @note This is used instead of a random number generator, so that no state is
+ * shared between threads.
+ */
+template <class K>
+inline uint64_t louvainHashVertex(K u, int l) {
+  uint64_t h = uint64_t(u) * 0x9E3779B97F4A7C15ULL ^ uint64_t(l+1) * 0xC2B2AE3D27D4EB4FULL;
+  h ^= h >> 31; h *= 0xBF58476D1CE4E5B9ULL; h ^= h >> 29;
+  return h;
+}
 
 
-#pragma region COMMUNITY PROPERTIES
 /**
- * Examine if each community exists.
- * @param a does each community exist (updated)
- * @param x original graph
- * @param vcom community each vertex belongs to
- * @returns number of communities
+ * Check if a stale vertex should be skipped in an iteration.
+ * @param u given vertex
+ * @param l current iteration
+ * @param s number of consecutive non-moves beyond the pruning threshold
+ * @returns skip the vertex? (with probability (s+1)/(s+2))
  */
-template <class G, class K, class A>
-inline size_t louvainCommunityExistsW(vector<A>& a, const G& x, const vector<K>& vcom) {
-  size_t C = 0;
-  fillValueU(a, A());
-  x.forEachVertexKey([&](auto u) {
-    K c = vcom[u];
-    if (!a[c]) ++C;
-    a[c] = A(1);
-  });
-  return C;
+template <class K>
+inline bool louvainSkipStaleVertex(K u, int l, int s) {
+  return (louvainHashVertex(u, l) >> 32) % uint64_t(s+2) != 0;
 }
 
 
-#ifdef OPENMP
 /**
- * Examine if each community exists.
- * @param a does each community exist (updated)
+ * Louvain algorithm's local moving phase, skipping vertices that keep staying put.
+ * @param vcom community each vertex belongs to (initial, updated)
+ * @param ctot total edge weight of each community (precalculated, updated)
+ * @param vaff is vertex affected flag (updated)
+ * @param vstl consecutive non-moves of each vertex (updated, must be initialized)
+ * @param ns number of skipped vertex scans (updated)
+ * @param vcs communities vertex u is linked to (temporary buffer, updated)
+ * @param vcout total edge weight from vertex u to community C (temporary buffer, updated)
  * @param x original graph
- * @param vcom community each vertex belongs to
- * @returns number of communities
+ * @param vtot total edge weight of each vertex
+ * @param M total weight of "undirected" graph (1/2 of directed graph)
+ * @param R resolution (0, 1]
+ * @param L max iterations
+ * @param Q consecutive non-moves after which a vertex may be skipped
+ * @param fc has local moving phase converged?
+ * @param fa is vertex allowed to be updated?
+ * @returns iterations performed (0 if converged already)
+ * @note A skipped vertex stays affected, and is considered again in the next
+ * iteration, with a rising chance of being skipped again.
  */
-template <class G, class K, class A>
-inline size_t louvainCommunityExistsOmpW(vector<A>& a, const G& x, const vector<K>& vcom) {
+template <class G, class K, class W, class B, class FC, class FA>
+CPU_CLONES inline int louvainMovePrunedOmpW(vector<K>& vcom, vector<W>& ctot, vector<B>& vaff, vector<uint8_t>& vstl, size_t& ns, vector<vector<K>*>& vcs, vector<vector<W>*>& vcout, const G& x, const vector<W>& vtot, double M, double R, int L, int Q, FC fc, FA fa) {
   size_t S = x.span();
-  size_t C = 0;
-  fillValueOmpU(a, A());
-  #pragma omp parallel for schedule(static, 2048) reduction(+:C)
-  for (K u=0; u<S; ++u) {
-    if (!x.hasVertex(u)) continue;
-    K c = vcom[u];
-    A m = A();
-    #pragma omp atomic capture
-    { m = a[c]; a[c] = A(1); }
-    if (!m) ++C;
+  int l = 0;
+  W  el = W();
+  for (; l<L;) {
+    el = W();
+    size_t n = 0;
+    #pragma omp parallel for schedule(dynamic, 2048) reduction(+:el, n)
+    for (K u=0; u<S; ++u) {
+      int t = omp_get_thread_num();
+      if (!hasVertex(x, u)) continue;
+      if (!fa(u) || !vaff[u]) continue;
+      int s = vstl[u];
+      if (s>=Q && louvainSkipStaleVertex(u, l, s-Q)) { ++n; continue; }
+      louvainClearScanW(*vcs[t], *vcout[t]);
+      louvainScanCommunitiesW(*vcs[t], *vcout[t], x, u, vcom);
+      auto [c, e] = louvainChooseCommunity(x, u, vcom, vtot, ctot, *vcs[t], *vcout[t], M, R);
+      if (c)      { louvainChangeCommunityOmpW(vcom, ctot, x, u, c, vtot); x.forEachEdgeKey(u, [&](auto v) { vaff[v] = B(1); }); }
+      vstl[u] = c? 0 : uint8_t(min(s+1, 255));
+      vaff[u] = B();
+      el += e;  // l1-norm
+    }
+    ns += n;
+    if (fc(el, l++)) break;
   }
-  return C;
+  return l>1 || el? l : 0;
 }
-#endif
-
-
 
 
 /**
- * Find the total degree of each community.
- * @param a total degree of each community (updated)
+ * Louvain algorithm's local moving phase, skipping vertices that keep staying put.
+ * @param vcom community each vertex belongs to (initial, updated)
+ * @param ctot total edge weight of each community (precalculated, updated)
+ * @param vaff is vertex affected flag (updated)
+ * @param vstl consecutive non-moves of each vertex (updated, must be initialized)
+ * @param ns number of skipped vertex scans (updated)
+ * @param vcs communities vertex u is linked to (temporary buffer, updated)
+ * @param vcout total edge weight from vertex u to community C (temporary buffer, updated)
  * @param x original graph
- * @param vcom community each vertex belongs to
+ * @param vtot total edge weight of each vertex
+ * @param M total weight of "undirected" graph (1/2 of directed graph)
+ * @param R resolution (0, 1]
+ * @param L max iterations
+ * @param Q consecutive non-moves after which a vertex may be skipped
+ * @param fc has local moving phase converged?
+ * @returns iterations performed (0 if converged already)
  */
-template <class G, class K, class A>
-inline void louvainCommunityTotalDegreeW(vector<A>& a, const G& x, const vector<K>& vcom) {
-  fillValueU(a, A());
-  x.forEachVertexKey([&](auto u) {
-    K c   = vcom[u];
-    a[c] += x.degree(u);
-  });
+template <class G, class K, class W, class B, class FC>
+inline int louvainMovePrunedOmpW(vector<K>& vcom, vector<W>& ctot, vector<B>& vaff, vector<uint8_t>& vstl, size_t& ns, vector<vector<K>*>& vcs, vector<vector<W>*>& vcout, const G& x, const vector<W>& vtot, double M, double R, int L, int Q, FC fc) {
+  auto fa = [](auto u) { return true; };
+  return louvainMovePrunedOmpW(vcom, ctot, vaff, vstl, ns, vcs, vcout, x, vtot, M, R, L, Q, fc, fa);
 }
 
 
-#ifdef OPENMP
 /**
- * Find the total degree of each community.
- * @param a total degree of each community (updated)
+ * Scan communities connected to a vertex, using a random sample of its edges drawn in proportion to their weight.
+ * @param vcs communities vertex u is linked to (updated)
+ * @param vcout estimated total edge weight from vertex u to community C (updated)
  * @param x original graph
+ * @param u given vertex
  * @param vcom community each vertex belongs to
+ * @param D number of edges to sample (less than degree of u)
+ * @param l current iteration, to pick a different sample in each iteration
+ * @param T total edge weight of vertex u
+ * @param H weight of the heaviest edge of vertex u
+ * @returns number of edges sampled
+ * @note Edges are drawn with replacement, by picking a random edge and keeping
+ * it with probability w/H (rejection sampling), for at most 4D draws. Each kept
+ * edge then stands for T/n of weight, where n edges were kept, so that the
+ * estimates are unbiased.
  */
-template <class G, class K, class A>
-inline void louvainCommunityTotalDegreeOmpW(vector<A>& a, const G& x, const vector<K>& vcom) {
-  size_t S = x.span();
-  fillValueOmpU(a, A());
-  #pragma omp parallel for schedule(static, 2048)
-  for (K u=0; u<S; ++u) {
-    if (!x.hasVertex(u)) continue;
-    K c = vcom[u];
-    #pragma omp atomic
-    a[c] += x.degree(u);
+template <class G, class K, class W>
+inline size_t louvainScanSampledCommunitiesW(vector<K>& vcs, vector<W>& vcout, const G& x, K u, const vector<K>& vcom, size_t D, int l, W T, W H) {
+  size_t N = x.degree(u), n = 0;
+  uint64_t h = louvainHashVertex(u, l);
+  auto fr = [&]() {
+    uint64_t z = (h += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  };
+  for (size_t j=0; j<4*D && n<D; ++j) {
+    auto [v, w] = x.edgeAt(u, size_t(fr() % N));
+    if (W(w) < H * W(double(fr() >> 11) / double(1ULL << 53))) continue;
+    louvainScanCommunityW(vcs, vcout, u, v, W(1), vcom);
+    ++n;
   }
+  for (auto c : vcs)
+    vcout[c] *= T / W(n);
+  return n;
 }
-#endif
 
 
+/**
+ * Get the total edge weight found by a communities scan.
+ * @param vcs communities vertex u is linked to
+ * @param vcout total edge weight from vertex u to community C
+ * @returns total edge weight to all communities
+ */
+template <class K, class W>
+inline W louvainScannedWeight(const vector<K>& vcs, const vector<W>& vcout) {
+  W a = W();
+  for (K c : vcs)
+    a += vcout[c];
+  return a;
+}
 
 
 /**
- * Find the number of vertices in each community.
- * @param a number of vertices belonging to each community (updated)
+ * Choose connected community with best delta modularity, along with its lead over the runner-up.
  * @param x original graph
+ * @param u given vertex
  * @param vcom community each vertex belongs to
+ * @param vtot total edge weight of each vertex
+ * @param ctot total edge weight of each community
+ * @param vcs communities vertex u is linked to
+ * @param vcout total edge weight from vertex u to community C
+ * @param M total weight of "undirected" graph (1/2 of directed graph)
+ * @param R resolution (0, 1]
+ * @returns [best community, delta modularity, margin over next best choice]
+ * @note Staying in the current community is a choice with zero delta modularity.
+ * With fewer than two communities scanned, the margin is zero, as a sample
+ * that saw a single community says little about the others.
  */
-template <class G, class K, class A>
-inline void louvainCountCommunityVerticesW(vector<A>& a, const G& x, const vector<K>& vcom) {
-  fillValueU(a, A());
-  x.forEachVertexKey([&](auto u) {
-    K c = vcom[u];
-    ++a[c];
-  });
+template <class G, class K, class W>
+inline auto louvainChooseCommunityMargin(const G& x, K u, const vector<K>& vcom, const vector<W>& vtot, const vector<W>& ctot, const vector<K>& vcs, const vector<W>& vcout, double M, double R) {
+  K cmax = K(), d = vcom[u];
+  W emax = W(), enxt = numeric_limits<W>::lowest();
+  for (K c : vcs) {
+    if (c==d) continue;
+    W e = deltaModularity(vcout[c], vcout[d], vtot[u], ctot[c], ctot[d], M, R);
+    if (e>emax)      { enxt = emax; emax = e; cmax = c; }
+    else if (e>enxt) { enxt = e; }
+  }
+  if (vcs.size() < 2) return make_tuple(cmax, emax, W());
+  return make_tuple(cmax, emax, emax - enxt);
 }
 
 
-#ifdef OPENMP
 /**
- * Find the number of vertices in each community.
- * @param a number of vertices belonging to each community (updated)
+ * Louvain algorithm's local moving phase, with high-degree vertices scanning a sample of their edges.
+ * @param vcom community each vertex belongs to (initial, updated)
+ * @param ctot total edge weight of each community (precalculated, updated)
+ * @param vaff is vertex affected flag (updated)
+ * @param ns number of sampled vertex scans (updated)
+ * @param nr number of sampled vertex scans redone exactly (updated)
+ * @param vcs communities vertex u is linked to (temporary buffer, updated)
+ * @param vcout total edge weight from vertex u to community C (temporary buffer, updated)
  * @param x original graph
- * @param vcom community each vertex belongs to
+ * @param vtot total edge weight of each vertex
+ * @param M total weight of "undirected" graph (1/2 of directed graph)
+ * @param R resolution (0, 1]
+ * @param L max iterations
+ * @param D degree above which a vertex scans only a sample of D edges
+ * @param Z gain margin, in standard errors, below which a sampled scan is redone exactly
+ * @param fc has local moving phase converged?
+ * @param fa is vertex allowed to be updated?
+ * @returns iterations performed (0 if converged already)
+ * @note The error in estimated delta modularity of a sampled scan is roughly
+ * K/(M*sqrt(D)), where K is the estimated weight of edges to other vertices. If
+ * the best choice does not lead the next best choice by Z such errors, or the
+ * sample saw fewer than two communities, the vertex is scanned again exactly.
+ * The heaviest edge of each sampled vertex is found once per call, for
+ * sampling edges in proportion to their weight.
  */
-template <class G, class K, class A>
-inline void louvainCountCommunityVerticesOmpW(vector<A>& a, const G& x, const vector<K>& vcom) {
+template <class G, class K, class W, class B, class FC, class FA>
+CPU_CLONES inline int louvainMoveSampledOmpW(vector<K>& vcom, vector<W>& ctot, vector<B>& vaff, size_t& ns, size_t& nr, vector<vector<K>*>& vcs, vector<vector<W>*>& vcout, const G& x, const vector<W>& vtot, double M, double R, int L, size_t D, double Z, FC fc, FA fa) {
   size_t S = x.span();
-  fillValueOmpU(a, A());
-  #pragma omp parallel for schedule(static, 2048)
+  double F = Z / (M * sqrt(double(D)));
+  vector<W> vmax(S);
+  #pragma omp parallel for schedule(dynamic, 2048)
   for (K u=0; u<S; ++u) {
-    if (!x.hasVertex(u)) continue;
-    K c = vcom[u];
-    #pragma omp atomic
-    ++a[c];
+    if (!hasVertex(x, u) || x.degree(u) <= D) continue;
+    x.forEachEdge(u, [&](auto, auto w) { vmax[u] = max(vmax[u], W(w)); });
+  }
+  int l = 0;
+  W  el = W();
+  for (; l<L;) {
+    el = W();
+    size_t n = 0, r = 0;
+    #pragma omp parallel for schedule(dynamic, 2048) reduction(+:el, n, r)
+    for (K u=0; u<S; ++u) {
+      int t = omp_get_thread_num();
+      if (!hasVertex(x, u)) continue;
+      if (!fa(u) || !vaff[u]) continue;
+      K c = K(); W e = W(), m = W();
+      louvainClearScanW(*vcs[t], *vcout[t]);
+      if (x.degree(u) > D) {
+        louvainScanSampledCommunitiesW(*vcs[t], *vcout[t], x, u, vcom, D, l, vtot[u], vmax[u]);
+        tie(c, e, m) = louvainChooseCommunityMargin(x, u, vcom, vtot, ctot, *vcs[t], *vcout[t], M, R);
+        ++n;
+      }
+      if (x.degree(u) <= D || m <= F * louvainScannedWeight(*vcs[t], *vcout[t])) {
+        if (x.degree(u) > D) { louvainClearScanW(*vcs[t], *vcout[t]); ++r; }
+        louvainScanCommunitiesW(*vcs[t], *vcout[t], x, u, vcom);
+        tie(c, e) = louvainChooseCommunity(x, u, vcom, vtot, ctot, *vcs[t], *vcout[t], M, R);
+      }
+      if (c)      { louvainChangeCommunityOmpW(vcom, ctot, x, u, c, vtot); x.forEachEdgeKey(u, [&](auto v) { vaff[v] = B(1); }); }
+      vaff[u] = B();
+      el += e;  // l1-norm
+    }
+    ns += n;
+    nr += r;
+    if (fc(el, l++)) break;
   }
+  return l>1 || el? l : 0;
 }
-#endif
-
-
 
 
 /**
- * Find the vertices in each community.
- * @param coff csr offsets for vertices belonging to each community (updated)
- * @param cdeg number of vertices in each community (updated)
- * @param cedg vertices belonging to each community (updated)
+ * Louvain algorithm's local moving phase, with high-degree vertices scanning a sample of their edges.
+ * @param vcom community each vertex belongs to (initial, updated)
+ * @param ctot total edge weight of each community (precalculated, updated)
+ * @param vaff is vertex affected flag (updated)
+ * @param ns number of sampled vertex scans (updated)
+ * @param nr number of sampled vertex scans redone exactly (updated)
+ * @param vcs communities vertex u is linked to (temporary buffer, updated)
+ * @param vcout total edge weight from vertex u to community C (temporary buffer, updated)
  * @param x original graph
- * @param vcom community each vertex belongs to
- */
+ * @param vtot total edge weight of each vertex
+ * @param M total weight of "undirected" graph (1/2 of directed graph)
+ * @param R resolution (0, 1]
+ * @param L max iterations
+ * @param D degree above which a vertex scans only a sample of D edges
+ * @param Z gain margin, in standard errors, below which a sampled scan is redone exactly
+ * @param fc has local moving phase converged?
+ * @returns iterations performed (0 if converged already)
+ */
+template <class G, class K, class W, class B, class FC>
+inline int louvainMoveSampledOmpW(vector<K>& vcom, vector<W>& ctot, vector<B>& vaff, size_t& ns, size_t& nr, vector<vector<K>*>& vcs, vector<vector<W>*>& vcout, const G& x, const vector<W>& vtot, double M, double R, int L, size_t D, double Z, FC fc) {
+  auto fa = [](auto u) { return true; };
+  return louvainMoveSampledOmpW(vcom, ctot, vaff, ns, nr, vcs, vcout, x, vtot, M, R, L, D, Z, fc, fa);
+}
+
+
+/**
+ * Louvain algorithm's local moving phase, driven by work queues instead of sweeps.
+ * @param vcom community each vertex belongs to (initial, updated)
+ * @param ctot total edge weight of each community (precalculated, updated)
+ * @param vaff is vertex affected flag (updated)
+ * @param vcs communities vertex u is linked to (temporary buffer, updated)
+ * @param vcout total edge weight from vertex u to community C (temporary buffer, updated)
+ * @param x original graph
+ * @param vtot total edge weight of each vertex
+ * @param M total weight of "undirected" graph (1/2 of directed graph)
+ * @param R resolution (0, 1]
+ * @param L max iterations (each worth one visit of every initially affected vertex)
+ * @param fc has local moving phase converged? (unused, the phase ends when the queues drain)
+ * @param fa is vertex allowed to be updated?
+ * @returns vertices processed divided by vertices initially affected, rounded up (0 if no vertex moved)
+ * @note Affected vertices are queued, and a vertex that moves queues its
+ * neighbours which are not already queued (vaff is set while queued), as the
+ * synchronous kernel marks them. The phase ends when the queues drain, with no
+ * barrier between iterations, so the returned count is the work done in units
+ * of one visit of every initially affected vertex, not a number of sweeps.
+ */
+template <class G, class K, class W, class B, class FC, class FA>
+CPU_CLONES inline int louvainMoveAsyncOmpW(vector<K>& vcom, vector<W>& ctot, vector<B>& vaff, vector<vector<K>*>& vcs, vector<vector<W>*>& vcout, const G& x, const vector<W>& vtot, double M, double R, int L, FC, FA fa) {
+  // Moves made by each thread, padded to avoid false sharing.
+  struct alignas(64) Tally { size_t moves = 0; };
+  size_t S = x.span();
+  int    H = omp_get_max_threads();
+  vector<deque<K>> qs(H);
+  vector<Tally>    mvs(H);
+  // Queue initially affected vertices.
+  #pragma omp parallel
+  {
+    int t = omp_get_thread_num();
+    #pragma omp for schedule(static, 2048)
+    for (K u=0; u<S; ++u)
+      if (hasVertex(x, u) && fa(u) && vaff[u]) qs[t].push_back(u);
+  }
+  size_t N0 = 0;
+  for (int t=0; t<H; ++t)
+    N0 += qs[t].size();
+  if (N0==0) return 0;
+  // Process queued vertices, until no vertex is queued.
+  auto fp = [&](K u, auto push) {
+    int t = omp_get_thread_num();
+    __atomic_store_n(&vaff[u], B(), __ATOMIC_RELAXED);
+    louvainClearScanW(*vcs[t], *vcout[t]);
+    louvainScanCommunitiesW(*vcs[t], *vcout[t], x, u, vcom);
+    auto [c, e] = louvainChooseCommunity(x, u, vcom, vtot, ctot, *vcs[t], *vcout[t], M, R);
+    if (!c) return;
+    louvainChangeCommunityOmpW(vcom, ctot, x, u, c, vtot);
+    ++mvs[t].moves;
+    x.forEachEdgeKey(u, [&](auto v) {
+      if (__atomic_exchange_n(&vaff[v], B(1), __ATOMIC_RELAXED)) return;
+      if (fa(v)) push(K(v));
+    });
+  };
+  size_t D = drainWorkQueuesOmp(qs, fp, size_t(L) * N0);
+  size_t moves = 0;
+  for (int t=0; t<H; ++t)
+    moves += mvs[t].moves;
+  if (moves==0) return 0;
+  return int((D + N0 - 1) / N0);
+}
+
+
+/**
+ * Louvain algorithm's local moving phase, driven by work queues instead of sweeps.
+ * @param vcom community each vertex belongs to (initial, updated)
+ * @param ctot total edge weight of each community (precalculated, updated)
+ * @param vaff is vertex affected flag (updated)
+ * @param vcs communities vertex u is linked to (temporary buffer, updated)
+ * @param vcout total edge weight from vertex u to community C (temporary buffer, updated)
+ * @param x original graph
+ * @param vtot total edge weight of each vertex
+ * @param M total weight of "undirected" graph (1/2 of directed graph)
+ * @param R resolution (0, 1]
+ * @param L max iterations (each worth one visit of every initially affected vertex)
+ * @param fc has local moving phase converged?
+ * @returns iterations performed (0 if converged already)
+ */
+template <class G, class K, class W, class B, class FC>
+inline int louvainMoveAsyncOmpW(vector<K>& vcom, vector<W>& ctot, vector<B>& vaff, vector<vector<K>*>& vcs, vector<vector<W>*>& vcout, const G& x, const vector<W>& vtot, double M, double R, int L, FC fc) {
+  auto fa = [](auto u) { return true; };
+  return louvainMoveAsyncOmpW(vcom, ctot, vaff, vcs, vcout, x, vtot, M, R, L, fc, fa);
+}
+#endif
+#pragma endregion
+
+
+
+
+#pragma region COMMUNITY PROPERTIES
+/**
+ * Examine if each community exists.
+ * @param a does each community exist (updated)
+ * @param x original graph
+ * @param vcom community each vertex belongs to
+ * @returns number of communities
+ */
+template <class G, class K, class A>
+inline size_t louvainCommunityExistsW(vector<A>& a, const G& x, const vector<K>& vcom) {
+  size_t C = 0;
+  fillValueU(a, A());
+  x.forEachVertexKey([&](auto u) {
+    K c = vcom[u];
+    if (!a[c]) ++C;
+    a[c] = A(1);
+  });
+  return C;
+}
+
+
+#ifdef OPENMP
+/**
+ * Examine if each community exists.
+ * @param a does each community exist (updated)
+ * @param x original graph
+ * @param vcom community each vertex belongs to
+ * @returns number of communities
+ */
+template <class G, class K, class A>
+inline size_t louvainCommunityExistsOmpW(vector<A>& a, const G& x, const vector<K>& vcom) {
+  size_t S = x.span();
+  size_t C = 0;
+  fillValueOmpU(a, A());
+  #pragma omp parallel for schedule(static, 2048) reduction(+:C)
+  for (K u=0; u<S; ++u) {
+    if (!hasVertex(x, u)) continue;
+    K c = vcom[u];
+    A m = A();
+    #pragma omp atomic capture
+    { m = a[c]; a[c] = A(1); }
+    if (!m) ++C;
+  }
+  return C;
+}
+#endif
+
+
+
+
+/**
+ * Find the total degree of each community.
+ * @param a total degree of each community (updated)
+ * @param x original graph
+ * @param vcom community each vertex belongs to
+ */
+template <class G, class K, class A>
+inline void louvainCommunityTotalDegreeW(vector<A>& a, const G& x, const vector<K>& vcom) {
+  fillValueU(a, A());
+  x.forEachVertexKey([&](auto u) {
+    K c   = vcom[u];
+    a[c] += x.degree(u);
+  });
+}
+
+
+#ifdef OPENMP
+/**
+ * Find the total degree of each community.
+ * @param a total degree of each community (updated)
+ * @param x original graph
+ * @param vcom community each vertex belongs to
+ */
+template <class G, class K, class A>
+inline void louvainCommunityTotalDegreeOmpW(vector<A>& a, const G& x, const vector<K>& vcom) {
+  size_t S = x.span();
+  fillValueOmpU(a, A());
+  #pragma omp parallel for schedule(static, 2048)
+  for (K u=0; u<S; ++u) {
+    if (!hasVertex(x, u)) continue;
+    K c = vcom[u];
+    #pragma omp atomic
+    a[c] += x.degree(u);
+  }
+}
+#endif
+
+
+
+
+/**
+ * Find the number of vertices in each community.
+ * @param a number of vertices belonging to each community (updated)
+ * @param x original graph
+ * @param vcom community each vertex belongs to
+ */
+template <class G, class K, class A>
+inline void louvainCountCommunityVerticesW(vector<A>& a, const G& x, const vector<K>& vcom) {
+  fillValueU(a, A());
+  x.forEachVertexKey([&](auto u) {
+    K c = vcom[u];
+    ++a[c];
+  });
+}
+
+
+#ifdef OPENMP
+/**
+ * Find the number of vertices in each community.
+ * @param a number of vertices belonging to each community (updated)
+ * @param x original graph
+ * @param vcom community each vertex belongs to
+ */
+template <class G, class K, class A>
+inline void louvainCountCommunityVerticesOmpW(vector<A>& a, const G& x, const vector<K>& vcom) {
+  size_t S = x.span();
+  fillValueOmpU(a, A());
+  #pragma omp parallel for schedule(static, 2048)
+  for (K u=0; u<S; ++u) {
+    if (!hasVertex(x, u)) continue;
+    K c = vcom[u];
+    #pragma omp atomic
+    ++a[c];
+  }
+}
+#endif
+
+
+
+
+/**
+ * Find the vertices in each community.
+ * @param coff csr offsets for vertices belonging to each community (updated)
+ * @param cdeg number of vertices in each community (updated)
+ * @param cedg vertices belonging to each community (updated)
+ * @param x original graph
+ * @param vcom community each vertex belongs to
+ */
 template <class G, class K>
 inline void louvainCommunityVerticesW(vector<K>& coff, vector<K>& cdeg, vector<K>& cedg, const G& x, const vector<K>& vcom) {
   size_t C = coff.size() - 1;
@@ -805,7 +1332,7 @@ inline void louvainCommunityVerticesOmpW(vector<K>& coff, vector<K>& cdeg, vecto
   fillValueOmpU(cdeg, K());
   #pragma omp parallel for schedule(static, 2048)
   for (K u=0; u<S; ++u) {
-    if (!x.hasVertex(u)) continue;
+    if (!hasVertex(x, u)) continue;
     K c = vcom[u];
     csrAddEdgeOmpU(cdeg, cedg, coff, c, u);
   }
@@ -842,6 +1369,21 @@ inline void louvainLookupCommunitiesOmpU(vector<K>& a, const vector<K>& vcom) {
   for (size_t u=0; u<S; ++u)
     a[u] = vcom[a[u]];
 }
+
+
+/**
+ * Obtain community membership in a tree-like fashion (to handle aggregation).
+ * @param a output community each vertex belongs to (output, size |ucom|)
+ * @param ucom community each vertex belongs to (at the previous aggregation level)
+ * @param vcom community each vertex belongs to (at this aggregation level)
+ */
+template <class K>
+inline void louvainLookupCommunitiesOmpW(K *a, const vector<K>& ucom, const vector<K>& vcom) {
+  size_t S = ucom.size();
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t u=0; u<S; ++u)
+    a[u] = vcom[ucom[u]];
+}
 #endif
 #pragma endregion
 
@@ -894,7 +1436,7 @@ inline void louvainAggregateEdgesW(vector<K>& ydeg, vector<K>& yedg, vector<W>&
  * @param yoff offsets for vertices belonging to each community
  */
 template <class G, class K, class W>
-inline void louvainAggregateEdgesOmpW(vector<K>& ydeg, vector<K>& yedg, vector<W>& ywei, vector<vector<K>*>& vcs, vector<vector<W>*>& vcout, const G& x, const vector<K>& vcom, const vector<K>& coff, const vector<K>& cedg, const vector<size_t>& yoff) {
+CPU_CLONES inline void louvainAggregateEdgesOmpW(vector<K>& ydeg, vector<K>& yedg, vector<W>& ywei, vector<vector<K>*>& vcs, vector<vector<W>*>& vcout, const G& x, const vector<K>& vcom, const vector<K>& coff, const vector<K>& cedg, const vector<size_t>& yoff) {
   size_t C = coff.size() - 1;
   fillValueOmpU(ydeg, K());
   #pragma omp parallel for schedule(dynamic, 2048)
@@ -996,6 +1538,597 @@ inline void louvainAggregateOmpW(vector<size_t>& yoff, vector<K>& ydeg, vector<K
 
 
 
+#pragma region INCREMENTAL AGGREGATION
+#ifdef OPENMP
+/**
+ * Record a batch update in an aggregated graph kept from a previous run.
+ * @param h aggregated graph kept from a previous run (updated)
+ * @param deletions edge deletions in batch update
+ * @param insertions edge insertions in batch update
+ */
+template <class K, class V, class W>
+inline void louvainHierarchyAddBatchU(LouvainHierarchy<K, W>& h, const vector<tuple<K, K, V>>& deletions, const vector<tuple<K, K, V>>& insertions) {
+  if (h.membership.empty()) return;
+  for (const auto& [u, v, w] : deletions)
+    h.deltas.push_back({u, v, -W(w)});
+  for (const auto& [u, v, w] : insertions)
+    h.deltas.push_back({u, v, W(w)});
+}
+
+
+/**
+ * Map communities of a kept aggregated graph to renumbered communities.
+ * @param hmap renumbered community of each kept community, or -1 if it no longer exists (updated)
+ * @param hpre kept community of each renumbered community (updated)
+ * @param x original graph
+ * @param vcom renumbered community each vertex belongs to
+ * @param C number of renumbered communities
+ * @param h aggregated graph kept from a previous run
+ * @note Each kept community maps to the community of (any) one of its
+ * vertices, as ids of the kept and current runs need not match. When several
+ * kept communities map to the same community, only one keeps the mapping; the
+ * vertices of the others then mark it dirty (see louvainHierarchyDirtyOmpW).
+ */
+template <class G, class K, class W>
+inline void louvainHierarchyMapOmpW(vector<K>& hmap, vector<K>& hpre, const G& x, const vector<K>& vcom, size_t C, const LouvainHierarchy<K, W>& h) {
+  size_t HS = h.graph.span();
+  size_t HN = min(h.membership.size(), x.span());
+  hmap.assign(HS, K(-1));
+  hpre.assign(C,  K(-1));
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t u=0; u<HN; ++u) {
+    K a = h.membership[u];
+    if (a>=HS || !hasVertex(x, K(u))) continue;
+    #pragma omp atomic write
+    hmap[a] = vcom[u];
+  }
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t a=0; a<HS; ++a) {
+    K c = hmap[a];
+    if (c==K(-1)) continue;
+    #pragma omp atomic write
+    hpre[c] = K(a);
+  }
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t a=0; a<HS; ++a) {
+    K c = hmap[a];
+    if (c!=K(-1) && hpre[c]!=K(a)) hmap[a] = K(-1);
+  }
+}
+
+
+/**
+ * Find the renumbered community a vertex belonged to in a kept aggregated graph.
+ * @param hmap renumbered community of each kept community, or -1 if it no longer exists
+ * @param h aggregated graph kept from a previous run
+ * @param u given vertex
+ * @returns renumbered previous community, or -1 if none
+ */
+template <class K, class W>
+inline K louvainHierarchyCommunity(const vector<K>& hmap, const LouvainHierarchy<K, W>& h, K u) {
+  K a = u < h.membership.size()? h.membership[u] : K(-1);
+  return a < hmap.size()? hmap[a] : K(-1);
+}
+
+
+/**
+ * Mark communities whose vertices have changed since an aggregated graph was kept.
+ * @param cdty is community dirty flag, needing aggregation from scratch (updated)
+ * @param x original graph
+ * @param vcom renumbered community each vertex belongs to
+ * @param hmap renumbered community of each kept community, or -1 if it no longer exists
+ * @param h aggregated graph kept from a previous run
+ * @param C number of renumbered communities
+ * @returns number of dirty communities
+ */
+template <class B, class G, class K, class W>
+inline size_t louvainHierarchyDirtyOmpW(vector<B>& cdty, const G& x, const vector<K>& vcom, const vector<K>& hmap, const LouvainHierarchy<K, W>& h, size_t C) {
+  size_t S = x.span();
+  cdty.resize(C);
+  fillValueOmpU(cdty, B());
+  #pragma omp parallel for schedule(static, 2048)
+  for (K u=0; u<S; ++u) {
+    K d = louvainHierarchyCommunity(hmap, h, u);
+    K c = hasVertex(x, u)? vcom[u] : K(-1);
+    if (c==d) continue;
+    if (d!=K(-1)) cdty[d] = B(1);
+    if (c!=K(-1)) cdty[c] = B(1);
+  }
+  return countValueOmp(cdty.data(), C, B(1));
+}
+
+
+/**
+ * Obtain the changes to rows of clean communities in a kept aggregated graph.
+ * @param ps (row, column, weight) changes, sorted by row and column (updated)
+ * @param x original graph
+ * @param vcom renumbered community each vertex belongs to
+ * @param cdty is community dirty flag
+ * @param hmap renumbered community of each kept community, or -1 if it no longer exists
+ * @param h aggregated graph kept from a previous run
+ * @note Edge deltas are first mapped to the previous community of their
+ * target vertex. Edges of each vertex that changed community then move their
+ * weight from its previous community to its current one.
+ */
+template <class G, class K, class W, class B>
+inline void louvainHierarchyPatchesOmpW(vector<tuple<K, K, W>>& ps, const G& x, const vector<K>& vcom, const vector<B>& cdty, const vector<K>& hmap, const LouvainHierarchy<K, W>& h) {
+  size_t S = x.span();
+  size_t D = h.deltas.size();
+  int    T = omp_get_max_threads();
+  vector<vector<tuple<K, K, W>>> pt(T);
+  #pragma omp parallel
+  {
+    int t = omp_get_thread_num();
+    #pragma omp for schedule(static, 2048) nowait
+    for (size_t i=0; i<D; ++i) {
+      auto [u, v, w] = h.deltas[i];
+      if (!hasVertex(x, u) || cdty[vcom[u]]) continue;
+      K d = louvainHierarchyCommunity(hmap, h, v);
+      if (d!=K(-1)) pt[t].push_back({vcom[u], d, w});
+    }
+    #pragma omp for schedule(dynamic, 2048) nowait
+    for (K v=0; v<S; ++v) {
+      if (!hasVertex(x, v)) continue;
+      K c = vcom[v];
+      K d = louvainHierarchyCommunity(hmap, h, v);
+      if (c==d) continue;
+      x.forEachEdge(v, [&](auto u, auto w) {
+        K r = vcom[u];
+        if (cdty[r]) return;
+        if (d!=K(-1)) pt[t].push_back({r, d, -W(w)});
+        pt[t].push_back({r, c, W(w)});
+      });
+    }
+  }
+  ps.clear();
+  for (int t=0; t<T; ++t)
+    ps.insert(ps.end(), pt[t].begin(), pt[t].end());
+  sort(ps.begin(), ps.end(), [](const auto& a, const auto& b) {
+    return get<0>(a)!=get<0>(b)? get<0>(a)<get<0>(b) : get<1>(a)<get<1>(b);
+  });
+}
+
+
+/**
+ * Aggregate outgoing edges of each community, reusing rows of a kept aggregated graph.
+ * @param ydeg degree of each community (updated)
+ * @param yedg vertex ids of outgoing edges of each community (updated)
+ * @param ywei weights of outgoing edges of each community (updated)
+ * @param vcs communities vertex u is linked to (temporary buffer, updated)
+ * @param vcout total edge weight from vertex u to community C (temporary buffer, updated)
+ * @param x original graph
+ * @param vcom renumbered community each vertex belongs to
+ * @param coff offsets for vertices belonging to each community
+ * @param cedg vertices belonging to each community
+ * @param yoff offsets for vertices belonging to each community
+ * @param cdty is community dirty flag
+ * @param hmap renumbered community of each kept community, or -1 if it no longer exists
+ * @param hpre kept community of each renumbered community
+ * @param ps (row, column, weight) changes to rows of clean communities, sorted
+ * @param h aggregated graph kept from a previous run
+ * @param Z weight below which a patched edge is dropped
+ */
+template <class G, class K, class W, class B>
+CPU_CLONES inline void louvainAggregateEdgesIncrementalOmpW(vector<K>& ydeg, vector<K>& yedg, vector<W>& ywei, vector<vector<K>*>& vcs, vector<vector<W>*>& vcout, const G& x, const vector<K>& vcom, const vector<K>& coff, const vector<K>& cedg, const vector<size_t>& yoff, const vector<B>& cdty, const vector<K>& hmap, const vector<K>& hpre, const vector<tuple<K, K, W>>& ps, const LouvainHierarchy<K, W>& h, W Z) {
+  size_t C = coff.size() - 1;
+  fillValueOmpU(ydeg, K());
+  #pragma omp parallel for schedule(dynamic, 2048)
+  for (K c=0; c<C; ++c) {
+    int t = omp_get_thread_num();
+    K   n = csrDegree(coff, c);
+    if (n==0) continue;
+    auto& hcs   = *vcs[t];
+    auto& hcout = *vcout[t];
+    louvainClearScanW(hcs, hcout);
+    if (cdty[c] || hpre[c]==K(-1)) {
+      csrForEachEdgeKey(coff, cedg, c, [&](auto u) {
+        louvainScanCommunitiesW<true>(hcs, hcout, x, u, vcom);
+      });
+      for (auto d : hcs)
+        csrAddEdgeU(ydeg, yedg, ywei, yoff, c, d, hcout[d]);
+      continue;
+    }
+    h.graph.forEachEdge(hpre[c], [&](auto a, auto w) {
+      K d = hmap[a];
+      if (d==K(-1)) return;
+      hcs.push_back(d);
+      hcout[d] = w;
+    });
+    auto fl = [](const auto& p, K r) { return get<0>(p) < r; };
+    auto it = lower_bound(ps.begin(), ps.end(), c, fl);
+    for (; it!=ps.end() && get<0>(*it)==c;) {
+      K d = get<1>(*it);
+      W w = W();
+      for (; it!=ps.end() && get<0>(*it)==c && get<1>(*it)==d; ++it)
+        w += get<2>(*it);
+      if (!hcout[d]) hcs.push_back(d);
+      hcout[d] += w;
+    }
+    for (auto d : hcs)
+      if (hcout[d] > Z) csrAddEdgeU(ydeg, yedg, ywei, yoff, c, d, hcout[d]);
+  }
+}
+
+
+/**
+ * Keep the aggregated graph of a first pass, for reuse in the next run.
+ * @param h aggregated graph kept from a previous run (updated)
+ * @param x original graph
+ * @param vcom renumbered community each vertex belongs to
+ * @param y aggregated graph, with spare capacity
+ */
+template <class G, class K, class W>
+inline void louvainHierarchyKeepOmpW(LouvainHierarchy<K, W>& h, const G& x, const vector<K>& vcom, const DiGraphCsr<K, None, W>& y) {
+  size_t S = x.span();
+  size_t C = y.span();
+  auto&  g = h.graph;
+  h.membership.resize(S);
+  #pragma omp parallel for schedule(static, 2048)
+  for (K u=0; u<S; ++u)
+    h.membership[u] = hasVertex(x, u)? vcom[u] : K(-1);
+  g.respan(C);
+  vector<size_t> bufs(omp_get_max_threads());
+  copyValuesOmpW(g.degrees, y.degrees);
+  copyValuesOmpW(g.offsets.data(), y.degrees.data(), C);
+  g.offsets[C] = exclusiveScanOmpW(g.offsets.data(), bufs.data(), g.offsets.data(), C);
+  g.edgeKeys  .resize(g.offsets[C]);
+  g.edgeValues.resize(g.offsets[C]);
+  #pragma omp parallel for schedule(dynamic, 2048)
+  for (K c=0; c<C; ++c) {
+    size_t i = y.offsets[c], j = g.offsets[c], n = y.degrees[c];
+    copy(y.edgeKeys  .begin()+i, y.edgeKeys  .begin()+i+n, g.edgeKeys  .begin()+j);
+    copy(y.edgeValues.begin()+i, y.edgeValues.begin()+i+n, g.edgeValues.begin()+j);
+  }
+  h.deltas.clear();
+}
+#endif
+#pragma endregion
+
+
+
+
+#pragma region STABLE COMMUNITY IDS
+/**
+ * Find the previous community with maximum overlap for each community.
+ * @param cbst previous community with maximum overlap, or |S| if none (updated)
+ * @param covl number of vertices in the overlap (updated)
+ * @param vcs previous communities of community c (temporary buffer, updated)
+ * @param vcout overlap with each previous community (temporary buffer, updated)
+ * @param coff offsets for vertices belonging to each community
+ * @param cedg vertices belonging to each community
+ * @param c given community
+ * @param qcom previous community each vertex belongs to (ids of |S| or more are ignored)
+ * @note In dynamic mode, communities whose vertices all had the same previous
+ * community (most of them, after a small batch) are matched without hashing.
+ */
+template <bool DYNAMIC=false, class K>
+inline void louvainBestOverlapW(vector<K>& cbst, vector<K>& covl, vector<K>& vcs, vector<K>& vcout, const vector<K>& coff, const vector<K>& cedg, K c, const vector<K>& qcom) {
+  size_t S = cbst.size();
+  size_t Q = qcom.size();
+  K u0  = cedg[coff[c]];
+  K d0  = u0<Q? qcom[u0] : K(S);
+  K bst = K(S), ovl = K();
+  bool touched = !DYNAMIC || d0>=S;
+  if (!touched) csrForEachEdgeKey(coff, cedg, c, [&](auto u) { if (u>=Q || qcom[u]!=d0) touched = true; });
+  if (!touched) {
+    bst = d0;
+    ovl = csrDegree(coff, c);
+  }
+  else {
+    louvainClearScanW(vcs, vcout);
+    csrForEachEdgeKey(coff, cedg, c, [&](auto u) {
+      if (u>=Q || qcom[u]>=S) return;
+      K d = qcom[u];
+      if (!vcout[d]) vcs.push_back(d);
+      ++vcout[d];
+    });
+    for (K d : vcs) {
+      if (vcout[d]<ovl || (vcout[d]==ovl && d>bst)) continue;
+      bst = d; ovl = vcout[d];
+    }
+  }
+  cbst[c] = bst;
+  covl[c] = ovl;
+}
+
+
+/**
+ * Relabel communities such that they keep the ids of previous communities they overlap most with.
+ * @param vcom community each vertex belongs to (updated)
+ * @param x original graph
+ * @param qcom previous community each vertex belongs to (ids of |S| or more are ignored)
+ * @returns number of communities which retained a previous id
+ * @note Communities are matched greedily by overlap; ties go to smaller ids.
+ * Unmatched communities are given unused ids, so all ids remain less than |S|.
+ * In dynamic mode, communities lying within a single previous community are
+ * not hashed.
+ */
+template <bool DYNAMIC=false, class G, class K>
+inline size_t louvainStabilizeCommunitiesU(vector<K>& vcom, const G& x, const vector<K>& qcom) {
+  size_t S = x.span();
+  vector<K> coff(S+1), cdeg(S), cedg(S);
+  vector<K> cbst(S), covl(S), cmap(S), dwin(S, K(S));
+  vector<K> vcs, vcout(S);
+  louvainCommunityVerticesW(coff, cdeg, cedg, x, vcom);
+  // Find the best previous community, and the winner for each previous community.
+  for (K c=0; c<S; ++c) {
+    if (csrDegree(coff, c)==0) continue;
+    louvainBestOverlapW<DYNAMIC>(cbst, covl, vcs, vcout, coff, cedg, c, qcom);
+    K d = cbst[c];
+    if (d>=S) continue;
+    if (dwin[d]==S || covl[c]>covl[dwin[d]]) dwin[d] = c;
+  }
+  // Winners keep their previous id, others get an unused id.
+  size_t F = 0;
+  vector<K>& dlst = cdeg;
+  for (K d=0; d<S; ++d)
+    if (dwin[d]==S) dlst[F++] = d;
+  for (K c=0, i=0; c<S; ++c) {
+    if (csrDegree(coff, c)==0) continue;
+    K d = cbst[c];
+    cmap[c] = d<S && dwin[d]==c? d : dlst[i++];
+  }
+  louvainLookupCommunitiesU(vcom, cmap);
+  return S - F;
+}
+
+
+#ifdef OPENMP
+/**
+ * Relabel communities such that they keep the ids of previous communities they overlap most with.
+ * @param vcom community each vertex belongs to (updated)
+ * @param x original graph
+ * @param qcom previous community each vertex belongs to (ids of |S| or more are ignored)
+ * @returns number of communities which retained a previous id
+ * @note Communities are matched greedily by overlap; ties go to smaller ids.
+ * Unmatched communities are given unused ids, so all ids remain less than |S|.
+ * In dynamic mode, communities lying within a single previous community are
+ * not hashed. Claims are packed as 64-bit (overlap, ~community), so K must
+ * fit in 32 bits.
+ */
+template <bool DYNAMIC=false, class G, class K>
+inline size_t louvainStabilizeCommunitiesOmpU(vector<K>& vcom, const G& x, const vector<K>& qcom) {
+  static_assert(sizeof(K) <= 4, "Community claims pack (overlap, ~community) into 64 bits.");
+  using O = uint64_t;
+  size_t S = x.span();
+  int    T = omp_get_max_threads();
+  vector<K> coff(S+1), cdeg(S), cedg(S), bufk(T);
+  vector<K> cbst(S), covl(S), cmap(S), dfre(S), cunm(S);
+  vector<O> dclm(S);
+  vector<vector<K>*> vcs(T);
+  vector<vector<K>*> vcout(T);
+  louvainAllocateHashtablesW(vcs, vcout, S);
+  louvainCommunityVerticesOmpW(coff, cdeg, cedg, bufk, x, vcom);
+  // Find the best previous community, and claim it with (overlap, ~community).
+  fillValueOmpU(dclm, O());
+  #pragma omp parallel for schedule(dynamic, 2048)
+  for (K c=0; c<S; ++c) {
+    int t = omp_get_thread_num();
+    if (csrDegree(coff, c)==0) continue;
+    louvainBestOverlapW<DYNAMIC>(cbst, covl, *vcs[t], *vcout[t], coff, cedg, c, qcom);
+    K d = cbst[c];
+    if (d<S) atomicMaxOmpU(dclm[d], (O(covl[c]) << 32) | O(~uint32_t(c)));
+  }
+  louvainFreeHashtablesW(vcs, vcout);
+  // Winners keep their previous id, others are marked unmatched.
+  fillValueOmpU(dfre, K(1));
+  fillValueOmpU(cunm, K());
+  #pragma omp parallel for schedule(static, 2048)
+  for (K c=0; c<S; ++c) {
+    if (csrDegree(coff, c)==0) continue;
+    K d = cbst[c];
+    if (d<S && K(~uint32_t(dclm[d]))==c) { cmap[c] = d; dfre[d] = K(); }
+    else cunm[c] = K(1);
+  }
+  // Assign unused previous ids to unmatched communities, in order.
+  vector<K>& dpos = cdeg;
+  vector<K>& cpos = cedg;
+  vector<K>& dlst = covl;
+  size_t F = exclusiveScanOmpW(dpos.data(), bufk.data(), dfre.data(), S);
+  exclusiveScanOmpW(cpos.data(), bufk.data(), cunm.data(), S);
+  #pragma omp parallel for schedule(static, 2048)
+  for (K d=0; d<S; ++d)
+    if (dfre[d]) dlst[dpos[d]] = d;
+  #pragma omp parallel for schedule(static, 2048)
+  for (K c=0; c<S; ++c)
+    if (cunm[c]) cmap[c] = dlst[cpos[c]];
+  louvainLookupCommunitiesOmpU(vcom, cmap);
+  return S - F;
+}
+
+
+/**
+ * Relabel the communities of a dynamic result such that they keep the ids of previous communities.
+ * @param a louvain result (updated, with its stabilization time added)
+ * @param x updated graph
+ * @param qcom previous community each vertex belongs to
+ * @returns number of communities which retained a previous id
+ * @note Total community weights are recomputed for the new ids, so that the
+ * result can seed the next dynamic run.
+ */
+template <class G, class K, class W>
+inline size_t louvainStabilizeResultOmpU(LouvainResult<K, W>& a, const G& x, const vector<K>& qcom) {
+  size_t n = 0;
+  a.time += measureDuration([&]() {
+    n = louvainStabilizeCommunitiesOmpU<true>(a.membership, x, qcom);
+    fillValueOmpU(a.communityWeight, W());
+    louvainCommunityWeightsOmpW(a.communityWeight, x, a.membership, a.vertexWeight);
+  });
+  return n;
+}
+#endif
+#pragma endregion
+
+
+
+
+#pragma region CHECKPOINT
+/**
+ * Write the state of Louvain algorithm at the end of a pass.
+ * @param a output stream
+ * @param ucom community membership of each vertex in the original graph
+ * @param y aggregated graph (input to next pass)
+ * @param vtot total edge weight of each vertex in the aggregated graph
+ * @param ctot total edge weight of each community in the aggregated graph
+ * @param E tolerance for convergence in the next pass
+ * @param l number of iterations performed
+ * @param p number of passes performed
+ */
+template <class K, class W>
+inline void louvainWriteCheckpoint(ostream& a, const vector<K>& ucom, const DiGraphCsr<K, None, W>& y, const vector<W>& vtot, const vector<W>& ctot, double E, int l, int p) {
+  size_t CN = y.span();
+  writeBinaryHeader(a, BINARY_LOUVAIN_CHECKPOINT, sizeof(K), sizeof(W), sizeof(size_t));
+  writeBinaryValue(a, E);
+  writeBinaryValue(a, int32_t(l));
+  writeBinaryValue(a, int32_t(p));
+  writeBinaryValues(a, ucom);
+  writeBinaryCsrBody(a, y);
+  writeBinaryValues(a, vtot.data(), CN);
+  writeBinaryValues(a, ctot.data(), CN);
+}
+
+
+/**
+ * Write the state of Louvain algorithm at the end of a pass.
+ * @param pth checkpoint file path (replaced atomically)
+ * @param ucom community membership of each vertex in the original graph
+ * @param y aggregated graph (input to next pass)
+ * @param vtot total edge weight of each vertex in the aggregated graph
+ * @param ctot total edge weight of each community in the aggregated graph
+ * @param E tolerance for convergence in the next pass
+ * @param l number of iterations performed
+ * @param p number of passes performed
+ * @returns success?
+ */
+template <class K, class W>
+inline bool louvainWriteCheckpoint(const char *pth, const vector<K>& ucom, const DiGraphCsr<K, None, W>& y, const vector<W>& vtot, const vector<W>& ctot, double E, int l, int p) {
+  string tmp = string(pth) + ".tmp";
+  {
+    ofstream a(tmp, std::ios::binary);
+    louvainWriteCheckpoint(a, ucom, y, vtot, ctot, E, l, p);
+    if (!a) return false;
+  }
+  return rename(tmp.c_str(), pth)==0;
+}
+
+
+/**
+ * Wait for a background checkpoint write, and report if it failed.
+ * @param cthd background checkpoint writer (joined)
+ * @param cok did the write succeed? (set by the writer)
+ * @param pth checkpoint file path
+ */
+inline void louvainJoinCheckpoint(thread& cthd, const bool& cok, const char *pth) {
+  cthd.join();
+  if (!cok) LOG("Cannot write checkpoint %s\n", pth);
+}
+
+
+/**
+ * Read the state of Louvain algorithm at the end of a pass.
+ * @param a state of Louvain algorithm (updated)
+ * @param s input stream
+ * @returns success?
+ */
+template <class K, class W>
+inline bool louvainReadCheckpointW(LouvainCheckpoint<K, W>& a, istream& s) {
+  int32_t l = 0, p = 0;
+  if (!readBinaryHeader(s, BINARY_LOUVAIN_CHECKPOINT, sizeof(K), sizeof(W), sizeof(size_t))) return false;
+  if (!readBinaryValueW(a.tolerance, s)) return false;
+  if (!readBinaryValueW(l, s) || !readBinaryValueW(p, s)) return false;
+  if (!readBinaryValuesW(a.membership, s))  return false;
+  if (!readBinaryCsrBodyW(a.graph, s))      return false;
+  if (!readBinaryValuesW(a.vertexWeight, s, a.graph.span()))    return false;
+  if (!readBinaryValuesW(a.communityWeight, s, a.graph.span())) return false;
+  a.iterations = l;
+  a.passes     = p;
+  return a.vertexWeight.size()==a.graph.span() && a.communityWeight.size()==a.graph.span();
+}
+
+
+/**
+ * Read the state of Louvain algorithm at the end of a pass.
+ * @param a state of Louvain algorithm (updated)
+ * @param pth checkpoint file path
+ * @returns success?
+ */
+template <class K, class W>
+inline bool louvainReadCheckpointW(LouvainCheckpoint<K, W>& a, const char *pth) {
+  ifstream s(pth, std::ios::binary);
+  return louvainReadCheckpointW(a, s);
+}
+
+
+#ifdef OPENMP
+/**
+ * Check if the state of Louvain algorithm can be restored into the given buffers.
+ * @param q state of Louvain algorithm
+ * @param S span of original graph (size of membership and per-vertex buffers)
+ * @param Y space for edges in aggregated graph
+ * @returns is the state consistent, and does it fit?
+ * @note A checkpoint of a different graph with the same span, or a corrupt
+ * one that still passes its fingerprint, is caught here: all community and
+ * edge ids must lie within the aggregated graph, and its edges within space.
+ */
+template <class K, class W>
+inline bool louvainCheckpointFitsOmp(const LouvainCheckpoint<K, W>& q, size_t S, size_t Y) {
+  const auto& g = q.graph;
+  size_t CN = g.degrees.size();
+  size_t CM = g.edgeKeys.size();
+  if (q.membership.size()!=S || CN>S || CM>Y) return false;
+  if (g.offsets.size()!=CN+1 || g.edgeValues.size()!=CM) return false;
+  if (q.vertexWeight.size()!=CN || q.communityWeight.size()!=CN) return false;
+  if (g.offsets[0]!=0 || g.offsets[CN]!=CM) return false;
+  size_t bad = 0;
+  #pragma omp parallel for schedule(static, 2048) reduction(+:bad)
+  for (size_t u=0; u<S; ++u)
+    bad += size_t(q.membership[u])>=CN;
+  #pragma omp parallel for schedule(static, 2048) reduction(+:bad)
+  for (size_t u=0; u<CN; ++u) {
+    if (g.offsets[u]>g.offsets[u+1] || size_t(g.degrees[u]) > g.offsets[u+1]-g.offsets[u]) { ++bad; continue; }
+    for (size_t i=g.offsets[u], I=i+g.degrees[u]; i<I; ++i)
+      bad += size_t(g.edgeKeys[i])>=CN;
+  }
+  return bad==0;
+}
+
+
+/**
+ * Restore the state of Louvain algorithm at the end of a pass.
+ * @param ucom community membership of each vertex in the original graph (updated)
+ * @param vcom community each vertex belongs to in the aggregated graph (updated)
+ * @param vtot total edge weight of each vertex in the aggregated graph (updated)
+ * @param ctot total edge weight of each community in the aggregated graph (updated)
+ * @param vaff is vertex affected flag (updated)
+ * @param y aggregated graph (updated)
+ * @param q state of Louvain algorithm
+ * @returns success? (nothing is modified if the state does not fit, see louvainCheckpointFitsOmp)
+ */
+template <class K, class W, class B>
+inline bool louvainRestoreCheckpointOmpW(vector<K>& ucom, vector<K>& vcom, vector<W>& vtot, vector<W>& ctot, vector<B>& vaff, DiGraphCsr<K, None, W>& y, const LouvainCheckpoint<K, W>& q) {
+  size_t S  = ucom.size();
+  size_t CN = q.graph.span();
+  size_t CM = q.graph.edgeKeys.size();
+  if (!louvainCheckpointFitsOmp(q, S, y.edgeKeys.size())) return false;
+  if (vcom.size()<CN || vtot.size()<CN || ctot.size()<CN || vaff.size()<CN) return false;
+  y.respan(CN);
+  copyValuesOmpW(ucom, q.membership);
+  copyValuesOmpW(y.offsets, q.graph.offsets);
+  copyValuesOmpW(y.degrees, q.graph.degrees);
+  copyValuesOmpW(y.edgeKeys.data(),   q.graph.edgeKeys.data(),   CM);
+  copyValuesOmpW(y.edgeValues.data(), q.graph.edgeValues.data(), CM);
+  copyValuesOmpW(vtot.data(), q.vertexWeight.data(), CN);
+  louvainInitializeOmpW(vcom, ctot, y, vtot);
+  copyValuesOmpW(ctot.data(), q.communityWeight.data(), CN);
+  fillValueOmpU(vaff.data(), CN, B(1));
+  return true;
+}
+#endif
+#pragma endregion
+
+
+
+
 #pragma region ENVIRONMENT SETUP
 /**
  * Setup and perform the Louvain algorithm.
@@ -1102,7 +2235,7 @@ inline auto louvainInvoke(const G& x, const LouvainOptions& o, FI fi, FM fm, FA
       tp += duration(t0, t1);
     });
   }, o.repeat);
-  return LouvainResult<K, W>(ucom, utot, ctot, l, p, t, tm/o.repeat, ti/o.repeat, tp/o.repeat, tl/o.repeat, ta/o.repeat, countValue(vaff, B(1)));
+  return LouvainResult<K, W>(ucom, utot, ctot, l, p, t, tm/o.repeat, ti/o.repeat, tp/o.repeat, tl/o.repeat, ta/o.repeat, countValue(vaff, B(1)), 0, 0, 0, M);
 }
 
 
@@ -1111,13 +2244,18 @@ inline auto louvainInvoke(const G& x, const LouvainOptions& o, FI fi, FM fm, FA
  * Setup and perform the Louvain algorithm.
  * @param x original graph
  * @param o louvain options
- * @param fi initializing community membership and total vertex/community weights (vcom, vtot, ctot)
+ * @param fi initializing community membership and total vertex/community weights, returning total edge weight (vaff, vcom, vtot, ctot)
  * @param fm marking affected vertices (vaff, vcs, vcout, vcom, vtot, ctot)
  * @param fa is vertex allowed to be updated? (u)
- * @returns louvain result
+ * @param fr releasing the input graph, once the last run no longer needs it ()
+ * @param cpth checkpoint file path, written in background at the end of each pass [none]
+ * @param q state of Louvain algorithm to resume from [none]
+ * @param h aggregated graph of the previous run, reused and replaced by that of this run (updated) [none]
+ * @param out community each vertex belongs to, written by the last run instead of returned (output, size |S|) [none]
+ * @returns louvain result (without membership, if written to out)
  */
-template <bool DYNAMIC=false, class G, class FI, class FM, class FA>
-inline auto louvainInvokeOmp(const G& x, const LouvainOptions& o, FI fi, FM fm, FA fa) {
+template <bool DYNAMIC=false, class G, class FI, class FM, class FA, class FR>
+inline auto louvainInvokeOmp(const G& x, const LouvainOptions& o, FI fi, FM fm, FA fa, FR fr, const char *cpth=nullptr, const LouvainCheckpoint<typename G::key_type>* q=nullptr, LouvainHierarchy<typename G::key_type>* h=nullptr, typename G::key_type *out=nullptr) {
   using  K = typename G::key_type;
   using  W = LOUVAIN_WEIGHT_TYPE;
   using  B = char;
@@ -1125,10 +2263,10 @@ inline auto louvainInvokeOmp(const G& x, const LouvainOptions& o, FI fi, FM fm,
   double R = o.resolution;
   int    L = o.maxIterations, l = 0;
   int    P = o.maxPasses, p = 0;
-  // Get graph properties.
+  // Get graph properties (total edge weight is found by initialization).
   size_t X = x.size();
   size_t S = x.span();
-  double M = edgeWeightOmp(x)/2;
+  double M = 0;
   // Allocate buffers.
   int    T = omp_get_max_threads();
   vector<B> vaff(S);        // Affected vertex flag (any pass)
@@ -1139,49 +2277,91 @@ inline auto louvainInvokeOmp(const G& x, const LouvainOptions& o, FI fi, FM fm,
   vector<size_t> bufs(T);   // Buffer for exclusive scan
   vector<vector<K>*> vcs(T);    // Hashtable keys
   vector<vector<W>*> vcout(T);  // Hashtable values
+  vector<W> cchk;           // Total community weights (checkpoint snapshot)
+  vector<uint8_t> vstl;     // Consecutive non-moves of each vertex (pruning)
+  size_t    ns = 0;         // Number of skipped vertex scans (pruning)
+  size_t    nm = 0;         // Number of sampled vertex scans (sampling)
+  size_t    nr = 0;         // Number of sampled vertex scans redone exactly (sampling)
+  thread    cthd;           // Background checkpoint writer
+  bool      cok = true;     // Did the last checkpoint write succeed?
+  LouvainHierarchy<K, W> hn;     // Aggregated graph of first pass (kept for next run)
+  vector<K> hmap, hpre;          // Kept to renumbered community, and back (kept graph)
+  vector<B> cdty;                // Community needs aggregation from scratch? (kept graph)
+  vector<tuple<K, K, W>> hps;    // Changes to rows of clean communities (kept graph)
+  bool hok = h && !h->membership.empty() && h->membership.size()<=S && h->deltas.size()<=X;
   if (!DYNAMIC) ucom.resize(S);
   if (!DYNAMIC) utot.resize(S);
   if (!DYNAMIC) ctot.resize(S);
+  if (cpth)     cchk.resize(S);
+  int Q = o.pruningThreshold;
+  if (Q>0)      vstl.resize(S);
+  size_t D = o.samplingDegree;
   louvainAllocateHashtablesW(vcs, vcout, S);
   size_t Z = max(size_t(o.aggregationTolerance * X), X);
   size_t Y = max(size_t(o.aggregationTolerance * Z), Z);
   DiGraphCsr<K, None, None, K> cv(S, S);  // CSR for community vertices
-  DiGraphCsr<K, None, W> y(S, Y);         // CSR for aggregated graph (input);  y(S, X)
+  DiGraphCsr<K, None, W> y(S, q? Y : 0);  // CSR for aggregated graph (input);  y(S, X)
   DiGraphCsr<K, None, W> z(S, Z);         // CSR for aggregated graph (output); z(S, X)
+  // NOTE: The input CSR gets space only when it becomes the output, after the
+  // first aggregation (when the input graph may have been released), and only
+  // as much as that aggregation needs.
   // Perform Louvain algorithm.
   float tm = 0, ti = 0, tp = 0, tl = 0, ta = 0;  // Time spent in different phases
+  int   r  = 0;  // Number of runs started
   float t  = measureDurationMarked([&](auto mark) {
     double E  = o.tolerance;
     auto   fc = [&](double el, int l) { return el<=E; };
-    // Reset buffers, in case of multiple runs.
-    fillValueOmpU(vaff, B());
-    fillValueOmpU(ucom, K());
-    fillValueOmpU(vcom, K());
-    fillValueOmpU(utot, W());
-    fillValueOmpU(vtot, W());
-    fillValueOmpU(ctot, W());
+    bool isLast = ++r==o.repeat;
+    // Aggregate the input graph into the larger CSR.
+    if (z.edgeKeys.size() < y.edgeKeys.size()) swap(y, z);
+    // Buffers need no reset between runs, as initialization overwrites them.
     cv.respan(S);
     y .respan(S);
     z .respan(S);
     // Time the algorithm.
     mark([&]() {
-      // Initialize community membership and total vertex/community weights.
-      ti += measureDuration([&]() { fi(ucom, utot, ctot); });
-      // Mark affected vertices.
-      tm += measureDuration([&]() { fm(vaff, vcs, vcout, ucom, utot, ctot); });
+      // Initialize community membership, total vertex/community weights, and total edge weight.
+      ti += measureDuration([&]() { M = fi(vaff, ucom, utot, ctot)/2; });
+      // Mark affected vertices, or restore state from checkpoint.
+      if (q) ti += measureDuration([&]() {
+        if (louvainRestoreCheckpointOmpW(ucom, vcom, vtot, ctot, vaff, y, *q)) return;
+        LOG("Checkpoint does not match graph, running from scratch\n");
+        q = nullptr;
+      });
+      if (!q) tm += measureDuration([&]() { fm(vaff, vcs, vcout, ucom, utot, ctot); });
+      if (q) E = q->tolerance;
       // Start timing first pass.
       auto t0 = timeNow(), t1 = t0;
       // Start local-moving, aggregation phases.
       // NOTE: In first pass, the input graph is a DiGraph.
       // NOTE: For subsequent passes, the input graph is a DiGraphCsr (optimization).
-      for (l=0, p=0; M>0 && P>0;) {
+      l = q? q->iterations : 0;
+      p = q? q->passes     : 0;
+      for (; M>0 && P>0;) {
         if (p==1) t1 = timeNow();
         bool isFirst = p==0;
         int m = 0;
         tl += measureDuration([&]() {
-          if (isFirst) m = louvainMoveOmpW(ucom, ctot, vaff, vcs, vcout, x, utot, M, R, L, fc, fa);
-          else         m = louvainMoveOmpW(vcom, ctot, vaff, vcs, vcout, y, vtot, M, R, L, fc);
+          if (Q>0) fillValueOmpU(vstl.data(), isFirst? S : y.span(), uint8_t());
+          if (o.asynchronous) {
+            if (isFirst) m = louvainMoveAsyncOmpW(ucom, ctot, vaff, vcs, vcout, x, utot, M, R, L, fc, fa);
+            else         m = louvainMoveAsyncOmpW(vcom, ctot, vaff, vcs, vcout, y, vtot, M, R, L, fc);
+          }
+          else if (Q>0) {
+            if (isFirst) m = louvainMovePrunedOmpW(ucom, ctot, vaff, vstl, ns, vcs, vcout, x, utot, M, R, L, Q, fc, fa);
+            else         m = louvainMovePrunedOmpW(vcom, ctot, vaff, vstl, ns, vcs, vcout, y, vtot, M, R, L, Q, fc);
+          }
+          else if (D>0) {
+            if (isFirst) m = louvainMoveSampledOmpW(ucom, ctot, vaff, nm, nr, vcs, vcout, x, utot, M, R, L, D, o.samplingMargin, fc, fa);
+            else         m = louvainMoveSampledOmpW(vcom, ctot, vaff, nm, nr, vcs, vcout, y, vtot, M, R, L, D, o.samplingMargin, fc);
+          }
+          else {
+            if (isFirst) m = louvainMoveOmpW(ucom, ctot, vaff, vcs, vcout, x, utot, M, R, L, fc, fa);
+            else         m = louvainMoveOmpW(vcom, ctot, vaff, vcs, vcout, y, vtot, M, R, L, fc);
+          }
         });
+        // Checkpoint of previous pass must be written before its data is modified.
+        if (cthd.joinable()) louvainJoinCheckpoint(cthd, cok, cpth);
         l += max(m, 1); ++p;
         if (m<=1 || p>=P) break;
         size_t GN = isFirst? x.order() : y.order();
@@ -1194,30 +2374,55 @@ inline auto louvainInvokeOmp(const G& x, const LouvainOptions& o, FI fi, FM fm,
         else         louvainRenumberCommunitiesOmpW(vcom, cv.degrees, bufk, y);
         if (isFirst) {}
         else         louvainLookupCommunitiesOmpU(ucom, vcom);
+        bool isKept = isFirst && hok;
+        if (isKept)  louvainHierarchyMapOmpW(hmap, hpre, x, ucom, CN, *h);
         ta += measureDuration([&]() {
+          // Output CSR needs space for each edge of the input graph.
+          size_t ZM = isFirst? X : sumValuesOmp(y.degrees.data(), GS, size_t());
+          if (z.edgeKeys.size() < ZM) {
+            z.edgeKeys  .resize(ZM);
+            z.edgeValues.resize(ZM);
+          }
           cv.respan(CN); z.respan(CN);
           if (isFirst) louvainCommunityVerticesOmpW(cv.offsets, cv.degrees, cv.edgeKeys, bufk, x, ucom);
           else         louvainCommunityVerticesOmpW(cv.offsets, cv.degrees, cv.edgeKeys, bufk, y, vcom);
-          if (isFirst) louvainAggregateOmpW(z.offsets, z.degrees, z.edgeKeys, z.edgeValues, bufs, vcs, vcout, x, ucom, cv.offsets, cv.edgeKeys);
-          else         louvainAggregateOmpW(z.offsets, z.degrees, z.edgeKeys, z.edgeValues, bufs, vcs, vcout, y, vcom, cv.offsets, cv.edgeKeys);
+          if (isKept) {
+            louvainHierarchyDirtyOmpW(cdty, x, ucom, hmap, *h, CN);
+            louvainHierarchyPatchesOmpW(hps, x, ucom, cdty, hmap, *h);
+            louvainCommunityTotalDegreeOmpW(z.offsets, x, ucom);
+            z.offsets[CN] = exclusiveScanOmpW(z.offsets.data(), bufs.data(), z.offsets.data(), CN);
+            louvainAggregateEdgesIncrementalOmpW(z.degrees, z.edgeKeys, z.edgeValues, vcs, vcout, x, ucom, cv.offsets, cv.edgeKeys, z.offsets, cdty, hmap, hpre, hps, *h, W(1e-12 * M));
+          }
+          else if (isFirst) louvainAggregateOmpW(z.offsets, z.degrees, z.edgeKeys, z.edgeValues, bufs, vcs, vcout, x, ucom, cv.offsets, cv.edgeKeys);
+          else              louvainAggregateOmpW(z.offsets, z.degrees, z.edgeKeys, z.edgeValues, bufs, vcs, vcout, y, vcom, cv.offsets, cv.edgeKeys);
+          if (isFirst && h) louvainHierarchyKeepOmpW(hn, x, ucom, z);
         });
+        // Input graph is not used after the first aggregation.
+        if (isFirst && isLast) fr();
         swap(y, z);
-        // fillValueOmpU(vcom.data(), CN, K());
-        // fillValueOmpU(ctot.data(), CN, W());
-        fillValueOmpU(vtot.data(), CN, W());
-        fillValueOmpU(vaff.data(), CN, B(1));
-        louvainVertexWeightsOmpW(vtot, y);
-        louvainInitializeOmpW(vcom, ctot, y, vtot);
+        ti += measureDuration([&]() { louvainInitializeFusedOmpW(vcom, vtot, ctot, vaff, y); });
         E /= o.toleranceDrop;
+        // Write checkpoint in background, overlapping with the next pass.
+        if (cpth) {
+          copyValuesOmpW(cchk.data(), ctot.data(), CN);
+          cthd = thread([&, E, l, p]() { cok = louvainWriteCheckpoint(cpth, ucom, y, vtot, cchk, E, l, p); });
+        }
       }
-      if (p<=1) {}
-      else      louvainLookupCommunitiesOmpU(ucom, vcom);
+      if (cthd.joinable()) louvainJoinCheckpoint(cthd, cok, cpth);
+      if (out && isLast) {
+        if (p<=1) copyValuesOmpW(out, ucom.data(), S);
+        else      louvainLookupCommunitiesOmpW(out, ucom, vcom);
+      }
+      else if (p>1) louvainLookupCommunitiesOmpU(ucom, vcom);
       if (p<=1) t1 = timeNow();
       tp += duration(t0, t1);
     });
   }, o.repeat);
   louvainFreeHashtablesW(vcs, vcout);
-  return LouvainResult<K, W>(ucom, utot, ctot, l, p, t, tm/o.repeat, ti/o.repeat, tp/o.repeat, tl/o.repeat, ta/o.repeat, countValueOmp(vaff, B(1)));
+  // Without a first-pass aggregation, the kept graph stays, with its deltas.
+  if (h && !hn.membership.empty()) *h = move(hn);
+  if (out) vector<K>().swap(ucom);
+  return LouvainResult<K, W>(ucom, utot, ctot, l, p, t, tm/o.repeat, ti/o.repeat, tp/o.repeat, tl/o.repeat, ta/o.repeat, countValueOmp(vaff, B(1)), ns/o.repeat, nm/o.repeat, nr/o.repeat, M);
 }
 #endif
 #pragma endregion
@@ -1279,20 +2484,208 @@ inline auto louvainStatic(const G& x, const LouvainOptions& o={}) {
  * Obtain the community membership of each vertex with Static Louvain.
  * @param x original graph
  * @param o louvain options
+ * @param cpth checkpoint file path, written at the end of each pass [none]
  * @returns louvain result
  */
 template <class G>
-inline auto louvainStaticOmp(const G& x, const LouvainOptions& o={}) {
+inline auto louvainStaticOmp(const G& x, const LouvainOptions& o={}, const char *cpth=nullptr) {
+  auto fi = [&](auto& vaff, auto& vcom, auto& vtot, auto& ctot)  {
+    return louvainInitializeFusedOmpW(vcom, vtot, ctot, vaff, x);
+  };
+  auto fm = [ ](auto& vaff, auto& vcs, auto& vcout, const auto& vcom, const auto& vtot, const auto& ctot) {};
+  auto fa = [ ](auto u) { return true; };
+  auto fr = [ ]() {};
+  return louvainInvokeOmp<false>(x, o, fi, fm, fa, fr, cpth);
+}
+
+
+/**
+ * Obtain the community membership of each vertex with Static Louvain, into a given buffer.
+ * @param a community each vertex belongs to (output, size |S|)
+ * @param x original graph
+ * @param o louvain options
+ * @returns louvain result (without membership)
+ * @note The membership is written by the last lookup of the last run, so it
+ * is never held twice.
+ */
+template <class G, class K>
+inline auto louvainStaticOmpW(K *a, const G& x, const LouvainOptions& o={}) {
+  auto fi = [&](auto& vaff, auto& vcom, auto& vtot, auto& ctot)  {
+    return louvainInitializeFusedOmpW(vcom, vtot, ctot, vaff, x);
+  };
+  auto fm = [ ](auto& vaff, auto& vcs, auto& vcout, const auto& vcom, const auto& vtot, const auto& ctot) {};
+  auto fa = [ ](auto u) { return true; };
+  auto fr = [ ]() {};
+  return louvainInvokeOmp<false>(x, o, fi, fm, fa, fr, nullptr, nullptr, nullptr, a);
+}
+
+
+/**
+ * Obtain the community membership of each vertex with Static Louvain, consuming the graph.
+ * @param x original graph (moved)
+ * @param o louvain options
+ * @param cpth checkpoint file path, written at the end of each pass [none]
+ * @returns louvain result
+ * @note The graph is cleared right after the first aggregation (of the last
+ * run), so that it does not coexist with the aggregated graphs. This lowers
+ * peak memory usage.
+ */
+template <class G, class=enable_if_t<!is_lvalue_reference<G>::value>>
+inline auto louvainStaticOmp(G&& x, const LouvainOptions& o={}, const char *cpth=nullptr) {
+  G a = move(x);
+  auto fi = [&](auto& vaff, auto& vcom, auto& vtot, auto& ctot)  {
+    return louvainInitializeFusedOmpW(vcom, vtot, ctot, vaff, a);
+  };
+  auto fm = [ ](auto& vaff, auto& vcs, auto& vcout, const auto& vcom, const auto& vtot, const auto& ctot) {};
+  auto fa = [ ](auto u) { return true; };
+  auto fr = [&]() { a.clear(); };
+  return louvainInvokeOmp<false>(a, o, fi, fm, fa, fr, cpth);
+}
+
+
+/**
+ * Resume Static Louvain from a checkpoint written at the end of a pass.
+ * @param x original graph
+ * @param cpth checkpoint file path (also updated at the end of each pass)
+ * @param o louvain options
+ * @returns louvain result
+ * @note If the checkpoint cannot be read, or does not match the graph (see
+ * louvainCheckpointFitsOmp), Static Louvain is run from scratch.
+ */
+template <class G>
+inline auto louvainResumeOmp(const G& x, const char *cpth, const LouvainOptions& o={}) {
+  using K = typename G::key_type;
+  LouvainCheckpoint<K> q;
+  bool ok = louvainReadCheckpointW(q, cpth);
+  auto fi = [&](auto& vaff, auto& vcom, auto& vtot, auto& ctot)  {
+    return louvainInitializeFusedOmpW(vcom, vtot, ctot, vaff, x);
+  };
+  auto fm = [ ](auto& vaff, auto& vcs, auto& vcout, const auto& vcom, const auto& vtot, const auto& ctot) {};
+  auto fa = [ ](auto u) { return true; };
+  auto fr = [ ]() {};
+  return louvainInvokeOmp<false>(x, o, fi, fm, fa, fr, cpth, ok? &q : nullptr);
+}
+#endif
+#pragma endregion
+
+
+
+
+#pragma region NAIVE-DYNAMIC APPROACH
+#ifdef OPENMP
+/**
+ * Obtain the community membership of each vertex with Naive-dynamic Louvain.
+ * @param y updated graph
+ * @param deletions edge deletions in batch update
+ * @param insertions edge insertions in batch update
+ * @param q initial community each vertex belongs to
+ * @param qvtot initial total edge weight of each vertex
+ * @param qctot initial total edge weight of each community
+ * @param o louvain options
+ * @param h aggregated graph of the previous run, reused and replaced (updated) [none]
+ * @returns louvain result (communities keep the ids of previous ones they overlap most with)
+ * @note Initial vectors must span the updated graph.
+ */
+template <class G, class K, class V, class W>
+inline auto louvainNaiveDynamicOmp(const G& y, const vector<tuple<K, K, V>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>& q, const vector<W>& qvtot, const vector<W>& qctot, const LouvainOptions& o={}, LouvainHierarchy<K, W>* h=nullptr) {
   using B = char;
-  auto fi = [&](auto& vcom, auto& vtot, auto& ctot)  {
-    louvainVertexWeightsOmpW(vtot, x);
-    louvainInitializeOmpW(vcom, ctot, x, vtot);
+  vector2d<K> qs;
+  vector2d<W> qvtots, qctots;
+  louvainSetupInitialsW(qs, qvtots, qctots, q, qvtot, qctot, o.repeat);
+  int r = 0;
+  auto fi = [&](auto& vaff, auto& vcom, auto& vtot, auto& ctot)  {
+    vcom = move(qs[r]);
+    vtot = move(qvtots[r]);
+    ctot = move(qctots[r]);
+    louvainUpdateWeightsFromOmpU(vtot, ctot, y, deletions, insertions, vcom);
+    ++r;
+    return edgeWeightOmp(y);
   };
-  auto fm = [ ](auto& vaff, const auto& vcom, const auto& vtot, const auto& ctot, auto& vcs,  auto& vcout) {
+  auto fm = [ ](auto& vaff, auto& vcs, auto& vcout, const auto& vcom, const auto& vtot, const auto& ctot) {
     fillValueOmpU(vaff, B(1));
   };
   auto fa = [ ](auto u) { return true; };
-  return louvainInvokeOmp<false>(x, o, fi, fm, fa);
+  auto fr = [ ]() {};
+  if (h) louvainHierarchyAddBatchU(*h, deletions, insertions);
+  auto a = louvainInvokeOmp<true>(y, o, fi, fm, fa, fr, nullptr, nullptr, h);
+  louvainStabilizeResultOmpU(a, y, q);
+  return a;
+}
+#endif
+#pragma endregion
+
+
+
+
+#pragma region DYNAMIC FRONTIER APPROACH
+#ifdef OPENMP
+/**
+ * Mark endpoints of edge deletions and insertions which may change community.
+ * @param vaff is vertex affected flag (updated)
+ * @param deletions edge deletions in batch update
+ * @param insertions edge insertions in batch update
+ * @param vcom community each vertex belongs to
+ */
+template <class B, class K, class V>
+inline void louvainAffectedVerticesFrontierOmpW(vector<B>& vaff, const vector<tuple<K, K, V>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>& vcom) {
+  size_t D = deletions.size();
+  size_t I = insertions.size();
+  fillValueOmpU(vaff, B());
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t i=0; i<D; ++i) {
+    K u = get<0>(deletions[i]);
+    K v = get<1>(deletions[i]);
+    if (vcom[u] != vcom[v]) continue;
+    vaff[u] = B(1);
+    vaff[v] = B(1);
+  }
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t i=0; i<I; ++i) {
+    K u = get<0>(insertions[i]);
+    K v = get<1>(insertions[i]);
+    if (vcom[u] == vcom[v]) continue;
+    vaff[u] = B(1);
+    vaff[v] = B(1);
+  }
+}
+
+
+/**
+ * Obtain the community membership of each vertex with Dynamic Frontier Louvain.
+ * @param y updated graph
+ * @param deletions edge deletions in batch update
+ * @param insertions edge insertions in batch update
+ * @param q initial community each vertex belongs to
+ * @param qvtot initial total edge weight of each vertex
+ * @param qctot initial total edge weight of each community
+ * @param o louvain options
+ * @param h aggregated graph of the previous run, reused and replaced (updated) [none]
+ * @returns louvain result (communities keep the ids of previous ones they overlap most with)
+ * @note Initial vectors must span the updated graph.
+ */
+template <class G, class K, class V, class W>
+inline auto louvainDynamicFrontierOmp(const G& y, const vector<tuple<K, K, V>>& deletions, const vector<tuple<K, K, V>>& insertions, const vector<K>& q, const vector<W>& qvtot, const vector<W>& qctot, const LouvainOptions& o={}, LouvainHierarchy<K, W>* h=nullptr) {
+  vector2d<K> qs;
+  vector2d<W> qvtots, qctots;
+  louvainSetupInitialsW(qs, qvtots, qctots, q, qvtot, qctot, o.repeat);
+  int r = 0;
+  auto fi = [&](auto& vaff, auto& vcom, auto& vtot, auto& ctot)  {
+    vcom = move(qs[r]);
+    vtot = move(qvtots[r]);
+    ctot = move(qctots[r]);
+    louvainUpdateWeightsFromOmpU(vtot, ctot, y, deletions, insertions, vcom);
+    ++r;
+    return edgeWeightOmp(y);
+  };
+  auto fm = [&](auto& vaff, auto& vcs, auto& vcout, const auto& vcom, const auto& vtot, const auto& ctot) {
+    louvainAffectedVerticesFrontierOmpW(vaff, deletions, insertions, vcom);
+  };
+  auto fa = [ ](auto u) { return true; };
+  auto fr = [ ]() {};
+  if (h) louvainHierarchyAddBatchU(*h, deletions, insertions);
+  auto a = louvainInvokeOmp<true>(y, o, fi, fm, fa, fr, nullptr, nullptr, h);
+  louvainStabilizeResultOmpU(a, y, q);
+  return a;
 }
 #endif
 #pragma endregion
@@ -0,0 +1,193 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#ifdef OPENMP
+#include <omp.h>
+#endif
+#include "_main.hxx"
+#include "Graph.hxx"
+#include "properties.hxx"
+#include "components.hxx"
+#include "louvain.hxx"
+
+using std::vector;
+using std::make_pair;
+using std::move;
+using std::sort;
+using std::max;
+
+
+
+
+#pragma region CONFIGURATION
+#ifndef LOUVAIN_SPLIT_TINY
+/** Components with at most this many vertices become a single community. */
+#define LOUVAIN_SPLIT_TINY 4
+#endif
+#ifndef LOUVAIN_SPLIT_LARGE
+/** Components with at least this many edges are clustered with all threads; smaller ones with one thread each. */
+#define LOUVAIN_SPLIT_LARGE size_t(1 << 18)
+#endif
+#pragma endregion
+
+
+
+
+#ifdef OPENMP
+#pragma region METHODS
+#pragma region HELPERS
+/**
+ * Extract a connected component of a graph, with local vertex ids.
+ * @param a output graph in CSR format (updated)
+ * @param x original graph
+ * @param vs vertices of the component, indexed by local id
+ * @param lid local id of each vertex
+ * @param parallel use all threads?
+ * @returns total edge weight of the component (each edge counted in both directions)
+ */
+template <class K, class V, class E, class O, class G>
+inline double louvainSplitComponentW(DiGraphCsr<K, V, E, O>& a, const G& x, const K *vs, const vector<K>& lid, bool parallel) {
+  size_t N = a.degrees.size();
+  double M = 0;
+  #pragma omp parallel for schedule(static, 2048) if(parallel)
+  for (size_t i=0; i<N; ++i)
+    a.degrees[i] = K(x.degree(vs[i]));
+  a.offsets[0] = O();
+  for (size_t i=0; i<N; ++i)
+    a.offsets[i+1] = a.offsets[i] + O(a.degrees[i]);
+  #pragma omp parallel for schedule(dynamic, 2048) reduction(+:M) if(parallel)
+  for (size_t i=0; i<N; ++i) {
+    size_t j = a.offsets[i];
+    x.forEachEdge(vs[i], [&](auto v, auto w) {
+      a.edgeKeys[j]   = lid[v];
+      a.edgeValues[j] = E(w);
+      M += w; ++j;
+    });
+  }
+  return M;
+}
+#pragma endregion
+
+
+
+
+#pragma region STATIC APPROACH
+/**
+ * Obtain the community membership of each vertex with Static Louvain, clustering each connected component separately.
+ * @param x original graph (symmetric)
+ * @param o louvain options
+ * @returns louvain result (initializationTime is the time spent splitting, and
+ * iterations and passes are the most of any component)
+ * @note Communities never span components, as merging disconnected parts only
+ * lowers modularity. So components are found first (in parallel), and:
+ * tiny ones (at most LOUVAIN_SPLIT_TINY vertices) become one community each,
+ * medium ones are clustered in parallel with the sequential kernel, one per
+ * thread (largest first), and large ones (at least LOUVAIN_SPLIT_LARGE edges)
+ * one after another with the parallel kernel. No component then waits on the
+ * convergence of another. Each component is clustered with resolution scaled
+ * by its share of the total edge weight, which makes its modularity agree
+ * with that of the whole graph. Community ids are vertex ids of the original
+ * graph. A graph with a single component is clustered as is.
+ */
+template <class G>
+inline auto louvainStaticSplitOmp(const G& x, const LouvainOptions& o={}) {
+  using  K = typename G::key_type;
+  using  E = typename G::edge_value_type;
+  using  W = LOUVAIN_WEIGHT_TYPE;
+  using  O = size_t;
+  size_t S = x.span();
+  double M = edgeWeightOmp(x);
+  vector<K> ucom(S), comp, lid(S), verts;
+  vector<W> utot(S), ctot(S);
+  vector<O> coff, cpos, cedg;
+  vector<size_t> medium, large;
+  LouvainOptions q = o;
+  q.repeat = 1;
+  int   l = 0, p = 0;
+  float ts = 0;
+  float t  = measureDuration([&]() {
+    size_t CN = 0;
+    l = 0; p = 0;
+    ts += measureDuration([&]() { CN = connectedComponentsOmpW(comp, x); });
+    // A connected graph is clustered as is.
+    if (CN<=1) {
+      auto a = louvainStaticOmp(x, q);
+      ucom = move(a.membership);
+      l = a.iterations; p = a.passes;
+      return;
+    }
+    ts += measureDuration([&]() {
+      // Number the components (by their roots), and count their vertices and edges.
+      coff.assign(S+1, O()); cpos.assign(S+1, O()); cedg.assign(S+1, O());
+      #pragma omp parallel for schedule(static, 2048)
+      for (size_t u=0; u<S; ++u) {
+        if (!hasVertex(x, K(u))) continue;
+        K r = comp[u];
+        #pragma omp atomic
+        ++coff[r];
+        #pragma omp atomic
+        cedg[r] += O(x.degree(K(u)));
+      }
+      // Group vertices by component, with local ids in order of placement.
+      vector<O> buf(omp_get_max_threads());
+      size_t N = exclusiveScanOmpW(coff.data(), buf.data(), coff.data(), S);
+      coff[S] = O(N);
+      copyValuesOmpW(cpos, coff);
+      verts.resize(N);
+      #pragma omp parallel for schedule(static, 2048)
+      for (size_t u=0; u<S; ++u) {
+        if (!hasVertex(x, K(u))) continue;
+        O i;
+        #pragma omp atomic capture
+        i = cpos[comp[u]]++;
+        verts[i] = K(u);
+        lid[u]   = K(i - coff[comp[u]]);
+      }
+      // Sort components by size, and let tiny ones be a single community.
+      medium.clear(); large.clear();
+      for (size_t r=0; r<S; ++r) {
+        size_t n = coff[r+1] - coff[r];
+        if (n==0 || comp[r]!=K(r)) continue;
+        if (n<=LOUVAIN_SPLIT_TINY) continue;
+        if (cedg[r]>=LOUVAIN_SPLIT_LARGE) large.push_back(r);
+        else medium.push_back(r);
+      }
+      sort(medium.begin(), medium.end(), [&](size_t r, size_t s) { return cedg[r] > cedg[s]; });
+      #pragma omp parallel for schedule(static, 2048)
+      for (size_t u=0; u<S; ++u)
+        ucom[u] = comp[u];
+    });
+    // Cluster a component, and map its communities back to original vertex ids.
+    auto fc = [&](size_t r, bool parallel) {
+      size_t n = coff[r+1] - coff[r];
+      const K *vs = verts.data() + coff[r];
+      DiGraphCsr<K, None, E, O> y(n, cedg[r]);
+      LouvainOptions qr = q;
+      qr.resolution = q.resolution * louvainSplitComponentW(y, x, vs, lid, parallel) / M;
+      auto a = parallel? louvainStaticOmp(y, qr) : louvainStatic(y, qr);
+      #pragma omp parallel for schedule(static, 2048) if(parallel)
+      for (size_t i=0; i<n; ++i)
+        ucom[vs[i]] = vs[a.membership[i]];
+      return make_pair(a.iterations, a.passes);
+    };
+    for (size_t r : large) {
+      auto [lr, pr] = fc(r, true);
+      l = max(l, lr); p = max(p, pr);
+    }
+    #pragma omp parallel for schedule(dynamic, 1) reduction(max:l, p)
+    for (size_t i=0; i<medium.size(); ++i) {
+      auto [lr, pr] = fc(medium[i], false);
+      l = max(l, lr); p = max(p, pr);
+    }
+  }, o.repeat);
+  fillValueOmpU(utot, W());
+  fillValueOmpU(ctot, W());
+  louvainVertexWeightsOmpW(utot, x);
+  louvainCommunityWeightsOmpW(ctot, x, ucom, utot);
+  return LouvainResult<K, W>(ucom, utot, ctot, l, p, t, 0, ts/o.repeat, 0, 0, 0, 0, 0, 0, 0, M/2);
+}
+#pragma endregion
+#pragma endregion
+#endif
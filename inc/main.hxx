@@ -5,10 +5,20 @@
 #include "Graph.hxx"
 #include "update.hxx"
 #include "mtx.hxx"
+#include "edgelist.hxx"
 #include "duplicate.hxx"
+#include "compact.hxx"
 #include "symmetricize.hxx"
 #include "selfLoop.hxx"
 #include "properties.hxx"
 #include "csr.hxx"
+#include "numa.hxx"
+#include "fingerprint.hxx"
+#include "binary.hxx"
+#include "shared.hxx"
 #include "batch.hxx"
+#include "components.hxx"
 #include "louvain.hxx"
+#include "louvainSplit.hxx"
+#include "autoconfig.hxx"
+#include "cache.hxx"
@@ -6,6 +6,8 @@
 #include <fstream>
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <vector>
 #include "_main.hxx"
 #include "Graph.hxx"
 #include "update.hxx"
@@ -14,6 +16,9 @@
 #endif
 
 using std::tuple;
+using std::vector;
+using std::get;
+using std::copy;
 using std::string;
 using std::istream;
 using std::istringstream;
@@ -107,6 +112,115 @@ inline size_t readMtxSpan(const char* pth) {
 
 
 
+#pragma region READ EDGES CHUNKED
+/**
+ * Parse an edge from a line of text, as "u v [w]".
+ * @param line line of text
+ * @param weighted is it weighted?
+ * @param u source vertex (updated)
+ * @param v target vertex (updated)
+ * @param w edge weight, 1 if not weighted or zero (updated)
+ * @returns is the line an edge?
+ */
+inline bool parseEdgeLine(const char *line, bool weighted, size_t& u, size_t& v, double& w) {
+  char *p = (char*) line, *q = p;
+  u = strtoull(p, &q, 10); if (q==p) return false; p = q;
+  v = strtoull(p, &q, 10); if (q==p) return false; p = q;
+  w = weighted? strtod(p, &q) : 0;
+  if (w==0) w = 1;
+  return true;
+}
+
+
+#ifdef OPENMP
+/**
+ * Notify a chunk of parsed edges, each on the thread owning its source vertex.
+ * @param routed edges grouped by owner thread (scratch)
+ * @param cnts edge counts of each thread for each owner thread (scratch)
+ * @param edges parsed edges (u, v, w)
+ * @param E number of parsed edges
+ * @param symmetric notify each edge in both directions?
+ * @param fc on chunk, before its edges are notified (1 + largest vertex id in the chunk)
+ * @param fb on edge (u, v, w), called only on the thread owning u (see belongsOmp)
+ */
+template <class FC, class FB>
+inline void notifyEdgesOmp(vector<tuple<size_t, size_t, double>>& routed, vector<size_t>& cnts, const vector<tuple<size_t, size_t, double>>& edges, size_t E, bool symmetric, FC fc, FB fb) {
+  // Let the graph grow first, as edges are added concurrently.
+  size_t n = 0;
+  #pragma omp parallel for schedule(static, 2048) reduction(max:n)
+  for (size_t i=0; i<E; ++i)
+    n = max(n, max(get<0>(edges[i]), get<1>(edges[i])) + 1);
+  fc(n);
+  auto fe = [&](size_t i, auto fr) {
+    const auto& [u, v, w] = edges[i];
+    fr(u, edges[i]);
+    if (symmetric) fr(v, tuple<size_t, size_t, double>(v, u, w));
+  };
+  auto fp = [&](const auto& e) {
+    const auto& [u, v, w] = e;
+    fb(u, v, w);
+  };
+  routeOmp(routed, cnts, E, fe, fp);
+}
+
+
+/**
+ * Read lines of a text stream in chunks, parse them into edges in parallel,
+ * and notify each edge on the thread owning its source vertex.
+ * @param s input stream (past any header)
+ * @param symmetric notify each edge in both directions?
+ * @param comments characters which start a comment line (skipped)
+ * @param fp parse a line (i, line, fr), with index i among non-comment lines, and fr(u, v, w) for each edge
+ * @param fc on chunk, before its edges are notified (1 + largest vertex id in the chunk)
+ * @param fb on edge (u, v, w), called only on the thread owning u (see belongsOmp)
+ * @returns number of bytes read
+ */
+template <class FP, class FC, class FB>
+inline size_t readEdgeLinesDoOmp(istream& s, bool symmetric, const char *comments, FP fp, FC fc, FB fb) {
+  const int THREADS = omp_get_max_threads();
+  const int LINES   = 131072;
+  vector<string> lines(LINES);
+  vector<vector<tuple<size_t, size_t, double>>> parsed(THREADS);
+  vector<tuple<size_t, size_t, double>> edges, routed;
+  vector<size_t> offs(THREADS+1), cnts;
+  size_t bytes = 0;
+  for (size_t base=0;;) {
+    // Read several lines from the stream, skipping comments.
+    int READ = 0;
+    while (READ<LINES && getline(s, lines[READ])) {
+      const string& line = lines[READ];
+      bytes += line.size() + 1;
+      if (line.empty() || !strchr(comments, line[0])) ++READ;
+    }
+    if (READ==0) break;
+    // Parse lines using multiple threads.
+    #pragma omp parallel
+    {
+      auto& a = parsed[omp_get_thread_num()];
+      auto fr = [&](size_t u, size_t v, double w) { a.push_back({u, v, w}); };
+      a.clear();
+      #pragma omp for schedule(dynamic, 1024)
+      for (int i=0; i<READ; ++i)
+        fp(base + i, lines[i].c_str(), fr);
+    }
+    // Gather parsed edges of all threads.
+    for (int t=0; t<THREADS; ++t)
+      offs[t+1] = offs[t] + parsed[t].size();
+    edges.resize(offs[THREADS]);
+    #pragma omp parallel for schedule(static, 1)
+    for (int t=0; t<THREADS; ++t)
+      copy(parsed[t].begin(), parsed[t].end(), edges.begin() + offs[t]);
+    notifyEdgesOmp(routed, cnts, edges, offs[THREADS], symmetric, fc, fb);
+    base += READ;
+  }
+  return bytes;
+}
+#endif
+#pragma endregion
+
+
+
+
 #pragma region READ MTX DO
 /**
  * Read contents of MTX file.
@@ -146,50 +260,28 @@ inline void readMtxDo(const char *pth, bool weighted, FH fh, FB fb) {
  * @param s input stream
  * @param weighted is it weighted?
  * @param fh on header (symmetric, rows, cols, size)
- * @param fb on body line (u, v, w)
+ * @param fb on body line (u, v, w), called only on the thread owning u (see belongsOmp)
+ * @returns number of bytes read in the body
  */
 template <class FH, class FB>
-inline void readMtxDoOmp(istream& s, bool weighted, FH fh, FB fb) {
+inline size_t readMtxDoOmp(istream& s, bool weighted, FH fh, FB fb) {
   bool symmetric; size_t rows, cols, size;
   readMtxHeader(s, symmetric, rows, cols, size);
   fh(symmetric, rows, cols, size);
   size_t n = max(rows, cols);
-  if (n==0) return;
+  if (n==0) return 0;
   // Process body lines in parallel.
-  const int THREADS = omp_get_max_threads();
-  const int LINES   = 131072;
-  vector<string> lines(LINES);
-  vector<tuple<size_t, size_t, double>> edges(LINES);
-  while (true) {
-    // Read several lines from the stream.
-    int READ = 0;
-    for (int i=0; i<LINES; ++i, ++READ)
-      if (!getline(s, lines[i])) break;
-    if (READ==0) break;
-    // Parse lines using multiple threads.
-    #pragma omp parallel for schedule(dynamic, 1024)
-    for (int i=0; i<READ; ++i) {
-      char *line = (char*) lines[i].c_str();
-      size_t u = strtoull(line, &line, 10);
-      size_t v = strtoull(line, &line, 10);
-      double w = weighted? strtod(line, &line) : 0;
-      edges[i] = {u, v, w? w : 1};
-    }
-    // Notify parsed lines.
-    #pragma omp parallel
-    {
-      for (int i=0; i<READ; ++i) {
-        const auto& [u, v, w] = edges[i];
-        fb(u, v, w);
-        if (symmetric) fb(v, u, w);
-      }
-    }
-  }
+  auto fp = [&](size_t i, const char *line, auto fr) {
+    size_t u, v; double w;
+    if (parseEdgeLine(line, weighted, u, v, w)) fr(u, v, w);
+  };
+  auto fc = [](size_t n) {};
+  return readEdgeLinesDoOmp(s, symmetric, "%", fp, fc, fb);
 }
 template <class FH, class FB>
-inline void readMtxDoOmp(const char *pth, bool weighted, FH fh, FB fb) {
+inline size_t readMtxDoOmp(const char *pth, bool weighted, FH fh, FB fb) {
   ifstream s(pth);
-  readMtxDoOmp(s, weighted, fh, fb);
+  return readMtxDoOmp(s, weighted, fh, fb);
 }
 #endif
 #pragma endregion
@@ -231,21 +323,23 @@ inline void readMtxIfW(G &a, const char *pth, bool weighted, FV fv, FE fe) {
  * @param weighted is it weighted?
  * @param fv include vertex? (u, d)
  * @param fe include edge? (u, v, w)
+ * @returns number of bytes read in the body
  */
 template <class G, class FV, class FE>
-inline void readMtxIfOmpW(G &a, istream& s, bool weighted, FV fv, FE fe) {
+inline size_t readMtxIfOmpW(G &a, istream& s, bool weighted, FV fv, FE fe) {
   using K = typename G::key_type;
   using V = typename G::vertex_value_type;
   using E = typename G::edge_value_type;
   auto fh = [&](auto symmetric, auto rows, auto cols, auto size) { addVerticesIfU(a, K(1), K(max(rows, cols)+1), V(), fv); };
   auto fb = [&](auto u, auto v, auto w) { if (fe(K(u), K(v), K(w))) addEdgeOmpU(a, K(u), K(v), E(w)); };
-  readMtxDoOmp(s, weighted, fh, fb);
+  size_t B = readMtxDoOmp(s, weighted, fh, fb);
   updateOmpU(a);
+  return B;
 }
 template <class G, class FV, class FE>
-inline void readMtxIfOmpW(G &a, const char *pth, bool weighted, FV fv, FE fe) {
+inline size_t readMtxIfOmpW(G &a, const char *pth, bool weighted, FV fv, FE fe) {
   ifstream s(pth);
-  readMtxIfOmpW(a, s, weighted, fv, fe);
+  return readMtxIfOmpW(a, s, weighted, fv, fe);
 }
 #endif
 #pragma endregion
@@ -279,17 +373,18 @@ inline void readMtxW(G& a, const char *pth, bool weighted=false) {
  * @param a output graph (updated)
  * @param s input stream
  * @param weighted is it weighted?
+ * @returns number of bytes read in the body
  */
 template <class G>
-inline void readMtxOmpW(G& a, istream& s, bool weighted=false) {
+inline size_t readMtxOmpW(G& a, istream& s, bool weighted=false) {
   auto fv = [](auto u, auto d)         { return true; };
   auto fe = [](auto u, auto v, auto w) { return true; };
-  readMtxIfOmpW(a, s, weighted, fv, fe);
+  return readMtxIfOmpW(a, s, weighted, fv, fe);
 }
 template <class G>
-inline void readMtxOmpW(G& a, const char *pth, bool weighted=false) {
+inline size_t readMtxOmpW(G& a, const char *pth, bool weighted=false) {
   ifstream s(pth);
-  readMtxOmpW(a, s, weighted);
+  return readMtxOmpW(a, s, weighted);
 }
 #endif
 #pragma endregion
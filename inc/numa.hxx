@@ -0,0 +1,396 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/syscall.h>
+#ifdef OPENMP
+#include <omp.h>
+#endif
+#include "_main.hxx"
+#include "Graph.hxx"
+
+using std::unique_ptr;
+using std::vector;
+using std::min;
+using std::max;
+using std::find;
+using std::sort;
+
+
+
+
+#pragma region METHODS
+#pragma region SYSTEM
+/**
+ * Get the NUMA node of the calling thread.
+ * @returns node id, or 0 if unknown
+ * @note The node can change if the thread is not bound to a core (see
+ * OMP_PROC_BIND and OMP_PLACES).
+ */
+inline int numaCurrentNode() noexcept {
+  #ifdef SYS_getcpu
+  unsigned cpu = 0, node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr)==0) return int(node);
+  #endif
+  return 0;
+}
+
+
+/**
+ * Get the amount of memory available to new allocations, without swapping.
+ * @returns available memory in bytes, or 0 if unknown
+ */
+inline size_t numaAvailableMemory() noexcept {
+  FILE *f = fopen("/proc/meminfo", "r");
+  if (!f) return 0;
+  char line[256]; unsigned long long a = 0;
+  while (fgets(line, sizeof(line), f))
+    if (sscanf(line, "MemAvailable: %llu kB", &a)==1) break;
+  fclose(f);
+  return size_t(a) * 1024;
+}
+
+
+#ifdef OPENMP
+/**
+ * Get the number of NUMA nodes the threads of a parallel region run on.
+ * @returns number of nodes (at least 1)
+ */
+inline int numaNodesOmp() noexcept {
+  vector<int> tnode(omp_get_max_threads(), -1);
+  #pragma omp parallel
+  tnode[omp_get_thread_num()] = numaCurrentNode();
+  sort(tnode.begin(), tnode.end());
+  int a = 0;
+  for (size_t t=0; t<tnode.size(); ++t)
+    if (tnode[t]>=0 && (t==0 || tnode[t]!=tnode[t-1])) ++a;
+  return max(a, 1);
+}
+#endif
+#pragma endregion
+#pragma endregion
+
+
+
+
+#ifdef OPENMP
+#pragma region CLASSES
+/**
+ * Read-only directed graph in CSR representation, with one replica of its
+ * offsets and edges on each NUMA node.
+ * @tparam K key type (vertex id)
+ * @tparam V vertex value type (vertex data)
+ * @tparam E edge value type (edge weight)
+ * @tparam O offset type
+ * @note Each replica is written (and thus placed, by first touch) by the
+ * threads running on its node, and each thread reads the replica of its node.
+ * Threads must be bound to cores (e.g. OMP_PROC_BIND=close) for this to hold,
+ * and the number of threads must not grow after construction. Vertex ids are
+ * dense.
+ */
+template <class K=uint32_t, class V=None, class E=None, class O=size_t>
+class DiGraphNuma {
+  #pragma region TYPES
+  public:
+  /** Key type (vertex id). */
+  using key_type = K;
+  /** Vertex value type (vertex data). */
+  using vertex_value_type = V;
+  /** Edge value type (edge weight). */
+  using edge_value_type   = E;
+  /** View of a replica. */
+  using view_type = DiGraphCsrView<K, V, E, O>;
+  #pragma endregion
+
+
+  #pragma region DATA
+  protected:
+  /** Offsets of the outgoing edges of vertices, for each replica. */
+  vector<unique_ptr<O[]>> offsets;
+  /** Vertex ids of the outgoing edges of each vertex, for each replica. */
+  vector<unique_ptr<K[]>> edgeKeys;
+  /** Edge weights of the outgoing edges of each vertex, for each replica. */
+  vector<unique_ptr<E[]>> edgeValues;
+  /** View of each replica. */
+  vector<view_type> views;
+  /** Replica read by each thread. */
+  vector<int> threadReplica;
+  #pragma endregion
+
+
+  #pragma region METHODS
+  #pragma region PROPERTIES
+  public:
+  /**
+   * Get the number of replicas of the graph.
+   * @returns number of replicas
+   */
+  inline size_t replicas() const noexcept {
+    return views.size();
+  }
+
+  /**
+   * Get the memory used by a replica of the graph.
+   * @returns size of a replica in bytes
+   */
+  inline size_t replicaBytes() const noexcept {
+    return replicaBytes(span(), size());
+  }
+
+  /**
+   * Get the memory needed by a replica of a graph.
+   * @param N number of vertices
+   * @param M number of edges
+   * @returns size of a replica in bytes
+   */
+  static inline size_t replicaBytes(size_t N, size_t M) noexcept {
+    return (N+1)*sizeof(O) + M*(sizeof(K) + sizeof(E));
+  }
+
+  /**
+   * Get the replica of the graph read by the calling thread.
+   * @returns view of the replica
+   */
+  inline const view_type& local() const noexcept {
+    size_t t = omp_get_thread_num();
+    return views[t < threadReplica.size()? threadReplica[t] : 0];
+  }
+
+  /**
+   * Get the size of buffer required to store data associated with each vertex
+   * in the graph, indexed by its vertex-id.
+   * @returns size of buffer required
+   */
+  inline size_t span() const noexcept {
+    return views.empty()? 0 : views[0].span();
+  }
+
+  /**
+   * Get the number of vertices in the graph.
+   * @returns |V|
+   */
+  inline size_t order() const noexcept {
+    return span();
+  }
+
+  /**
+   * Obtain the number of edges in the graph.
+   * @returns |E|
+   */
+  inline size_t size() const noexcept {
+    return views.empty()? 0 : views[0].size();
+  }
+
+  /**
+   * Check if the graph is empty.
+   * @returns is the graph empty?
+   */
+  inline bool empty() const noexcept {
+    return span()==0;
+  }
+
+  /**
+   * Check if the graph is directed.
+   * @returns is the graph directed?
+   */
+  inline bool directed() const noexcept {
+    return true;
+  }
+  #pragma endregion
+
+
+  #pragma region FOREACH
+  public:
+  /**
+   * Iterate over the vertices in the graph.
+   * @param fp process function (vertex id, vertex data)
+   */
+  template <class FP>
+  inline void forEachVertex(FP fp) const noexcept {
+    for (K u=0; u<span(); ++u)
+      fp(u, V());
+  }
+
+  /**
+   * Iterate over the vertex ids in the graph.
+   * @param fp process function (vertex id)
+   */
+  template <class FP>
+  inline void forEachVertexKey(FP fp) const noexcept {
+    for (K u=0; u<span(); ++u)
+      fp(u);
+  }
+
+  /**
+   * Iterate over the outgoing edges of a source vertex in the graph.
+   * @param u source vertex id
+   * @param fp process function (target vertex id, edge weight)
+   */
+  template <class FP>
+  inline void forEachEdge(K u, FP fp) const noexcept {
+    local().forEachEdge(u, fp);
+  }
+
+  /**
+   * Iterate over the target vertex ids of a source vertex in the graph.
+   * @param u source vertex id
+   * @param fp process function (target vertex id)
+   */
+  template <class FP>
+  inline void forEachEdgeKey(K u, FP fp) const noexcept {
+    local().forEachEdgeKey(u, fp);
+  }
+  #pragma endregion
+
+
+  #pragma region ACCESS
+  public:
+  /**
+   * Check if a vertex exists in the graph.
+   * @param u vertex id
+   * @returns does the vertex exist?
+   */
+  inline bool hasVertex(K u) const noexcept {
+    return u < span();
+  }
+
+  /**
+   * Check if an edge exists in the graph.
+   * @param u source vertex id
+   * @param v target vertex id
+   * @returns does the edge exist?
+   */
+  inline bool hasEdge(K u, K v) const noexcept {
+    return local().hasEdge(u, v);
+  }
+
+  /**
+   * Get the number of outgoing edges of a vertex in the graph.
+   * @param u vertex id
+   * @returns number of outgoing edges of the vertex
+   */
+  inline size_t degree(K u) const noexcept {
+    return local().degree(u);
+  }
+
+  /**
+   * Get an outgoing edge of a vertex in the graph, by its position.
+   * @param u vertex id
+   * @param i edge index (< degree(u))
+   * @returns [target vertex id, edge weight]
+   */
+  inline pair<K, E> edgeAt(K u, size_t i) const noexcept {
+    return local().edgeAt(u, i);
+  }
+
+  /**
+   * Get the vertex data of a vertex in the graph.
+   * @param u vertex id
+   * @returns associated data of the vertex
+   */
+  inline V vertexValue(K u) const noexcept {
+    return V();
+  }
+
+  /**
+   * Get the edge weight of an edge in the graph.
+   * @param u source vertex id
+   * @param v target vertex id
+   * @returns associated weight of the edge
+   */
+  inline E edgeValue(K u, K v) const noexcept {
+    return local().edgeValue(u, v);
+  }
+  #pragma endregion
+  #pragma endregion
+
+
+  #pragma region CONSTRUCTORS
+  public:
+  /**
+   * Create an empty graph.
+   */
+  DiGraphNuma() {}
+
+  /**
+   * Replicate a graph with dense vertex ids on each NUMA node, in parallel.
+   * @param x graph with dense vertex ids
+   * @param R maximum number of replicas [0 => one per node]
+   * @note Replicas beyond the first are only made if they fit in half of the
+   * available memory. Nodes share replicas round-robin if there are fewer
+   * replicas than nodes.
+   */
+  template <class G>
+  DiGraphNuma(const G& x, size_t R=0) {
+    size_t N = x.span(), M = x.size();
+    int    H = omp_get_max_threads();
+    vector<O> off(N+1), bufo(H);
+    vector<int> tnode(H, -1), trank(H), rcount;
+    #pragma omp parallel for schedule(static, 2048)
+    for (size_t u=0; u<N; ++u)
+      off[u] = O(x.degree(K(u)));
+    off[N] = exclusiveScanOmpW(off.data(), bufo.data(), off.data(), N);
+    threadReplica.assign(H, 0);
+    #pragma omp parallel
+    {
+      int t = omp_get_thread_num();
+      tnode[t] = numaCurrentNode();
+      #pragma omp barrier
+      #pragma omp single
+      {
+        // Number the nodes in order of first appearance.
+        vector<int> nodes;
+        for (int s=0; s<H; ++s) {
+          if (tnode[s]<0) continue;
+          auto it = find(nodes.begin(), nodes.end(), tnode[s]);
+          threadReplica[s] = int(it - nodes.begin());
+          if (it==nodes.end()) nodes.push_back(tnode[s]);
+        }
+        size_t B  = replicaBytes(N, M);
+        size_t RM = 1 + numaAvailableMemory() / (2 * max(B, size_t(1)));
+        size_t RN = min(min(R? R : nodes.size(), RM), max(nodes.size(), size_t(1)));
+        rcount.assign(RN, 0);
+        for (int s=0; s<H; ++s) {
+          threadReplica[s] %= RN;
+          if (tnode[s]>=0) trank[s] = rcount[threadReplica[s]]++;
+        }
+        // Leave the arrays untouched, so that the filling threads place them.
+        for (size_t r=0; r<RN; ++r) {
+          offsets.emplace_back(new O[N+1]);
+          edgeKeys.emplace_back(new K[M]);
+          edgeValues.emplace_back(new E[M]);
+          views.push_back(view_type(N, offsets[r].get(), edgeKeys[r].get(), edgeValues[r].get()));
+        }
+      }
+      int r = threadReplica[t];
+      size_t T = rcount[r], i = trank[t];
+      size_t ub = N * i / T, ue = N * (i+1) / T;
+      O *ro = offsets[r].get();
+      K *rk = edgeKeys[r].get();
+      E *re = edgeValues[r].get();
+      if (i==0) ro[N] = off[N];
+      for (size_t u=ub; u<ue; ++u) {
+        size_t j = ro[u] = off[u];
+        x.forEachEdge(K(u), [&](auto v, auto w) { rk[j] = v; re[j] = w; ++j; });
+      }
+    }
+  }
+
+  // Views point into the owned arrays, which stay in place on a move.
+  DiGraphNuma(const DiGraphNuma&) = delete;
+  DiGraphNuma& operator=(const DiGraphNuma&) = delete;
+  DiGraphNuma(DiGraphNuma&&) = default;
+  DiGraphNuma& operator=(DiGraphNuma&&) = default;
+  #pragma endregion
+};
+
+
+
+
+template <class K, class V, class E, class O>
+struct IsDenseGraph<DiGraphNuma<K, V, E, O>> : true_type {};
+#pragma endregion
+#endif
@@ -2,7 +2,10 @@
 #include <vector>
 #include <cstdint>
 #include <cmath>
+#include <unordered_map>
+#include <algorithm>
 #include "_main.hxx"
+#include "csr.hxx"
 #include "bfs.hxx"
 #include "dfs.hxx"
 #ifdef OPENMP
@@ -10,7 +13,34 @@
 #endif
 
 using std::vector;
+using std::unordered_map;
 using std::pow;
+using std::log;
+using std::max;
+using std::sort;
+
+
+
+
+#pragma region TYPES
+/**
+ * Quality of a clustering, compared against a ground truth clustering.
+ */
+struct ClusteringQuality {
+  #pragma region DATA
+  /** Normalized mutual information (arithmetic mean normalization). */
+  double normalizedMutualInformation;
+  /** Adjusted Rand index. */
+  double adjustedRandIndex;
+  /** Fraction of co-clustered vertex pairs which are also co-clustered in ground truth. */
+  double pairPrecision;
+  /** Fraction of ground truth co-clustered vertex pairs which are also co-clustered. */
+  double pairRecall;
+  /** Harmonic mean of pair precision and recall. */
+  double pairF1Score;
+  #pragma endregion
+};
+#pragma endregion
 
 
 
@@ -99,7 +129,7 @@ inline double edgeWeightOmp(const G& x) {
   size_t S = x.span();
   #pragma omp parallel for schedule(auto) reduction(+:a)
   for (K u=0; u<S; ++u) {
-    if (!x.hasVertex(u)) continue;
+    if (!hasVertex(x, u)) continue;
     a += edgeWeight(x, u);
   }
   return a;
@@ -211,7 +241,7 @@ inline double modularityByOmp(const G& x, FC fc, double M, double R=1) {
   // Compute the internal and total weight of each vertex.
   #pragma omp parallel for schedule(dynamic, 2048)
   for (K u=0; u<S; ++u) {
-    if (!x.hasVertex(u)) continue;
+    if (!hasVertex(x, u)) continue;
     K c = fc(u);
     x.forEachEdge(u, [&](auto v, auto w) {
       K d = fc(v);
@@ -222,7 +252,7 @@ inline double modularityByOmp(const G& x, FC fc, double M, double R=1) {
   // Compute the internal and total weight of each community.
   #pragma omp parallel for schedule(static, 2048)
   for (K u=0; u<S; ++u) {
-    if (!x.hasVertex(u)) continue;
+    if (!hasVertex(x, u)) continue;
     K c = fc(u);
     #pragma omp atomic
     cin[c]  += vin[u];
@@ -291,7 +321,7 @@ inline vector<K> communitySizeOmp(const G& x, const vector<K>& vcom) {
   vector<K> a(S);
   #pragma omp parallel for schedule(static, 2048)
   for (K u=0; u<S; ++u) {
-    if (!x.hasVertex(u)) continue;
+    if (!hasVertex(x, u)) continue;
     K c = vcom[u];
     #pragma omp atomic
     ++a[c];
@@ -333,7 +363,7 @@ inline vector2d<K> communityVerticesOmp(const G& x, const vector<K>& vcom) {
   #pragma omp parallel
   {
     for (K u=0; u<S; ++u) {
-      if (!x.hasVertex(u)) continue;
+      if (!hasVertex(x, u)) continue;
       K c = vcom[u];
       if (belongsOmp(c)) a[c].push_back(u);
     }
@@ -400,4 +430,157 @@ inline vector<char> communitiesDisconnectedOmp(const G& x, const vector<K>& vcom
 }
 #endif
 #pragma endregion
+
+
+
+
+#pragma region CLUSTERING QUALITY
+/**
+ * Obtain the quality of a clustering, from statistics of its contingency table.
+ * @param N number of vertices
+ * @param nlnn sum of n log n, over each cell of the contingency table
+ * @param alna sum of a log a, over each community
+ * @param blnb sum of b log b, over each ground truth community
+ * @param npairs sum of n choose 2, over each cell of the contingency table
+ * @param apairs sum of a choose 2, over each community
+ * @param bpairs sum of b choose 2, over each ground truth community
+ * @param nlnab sum of n log(a b), over each cell of the contingency table
+ * @returns clustering quality
+ */
+inline ClusteringQuality clusteringQualityFrom(double N, double nlnn, double alna, double blnb, double npairs, double apairs, double bpairs, double nlnab) {
+  ClusteringQuality a;
+  double lnN = log(N);
+  double I   = (nlnn - nlnab)/N + lnN;
+  double HA  = lnN - alna/N;
+  double HB  = lnN - blnb/N;
+  double P   = N*(N-1)/2;
+  double E   = P>0? apairs*bpairs/P : 0;
+  double X   = (apairs + bpairs)/2;
+  a.normalizedMutualInformation = HA+HB>0? 2*I/(HA+HB) : 1;
+  a.adjustedRandIndex = X!=E? (npairs - E)/(X - E) : 1;
+  a.pairPrecision = apairs>0? npairs/apairs : 1;
+  a.pairRecall    = bpairs>0? npairs/bpairs : 1;
+  double pr = a.pairPrecision + a.pairRecall;
+  a.pairF1Score   = pr>0? 2*a.pairPrecision*a.pairRecall/pr : 0;
+  return a;
+}
+
+
+#ifdef OPENMP
+/**
+ * Renumber the labels of vertices to dense ids, in parallel.
+ * @param a dense label of each vertex (updated)
+ * @param asiz number of vertices with each dense label (updated)
+ * @param x given graph
+ * @param vcom label of each vertex (any values)
+ * @returns number of distinct labels
+ * @note Labels are routed to an owner thread by hash, and each owner counts
+ * its share in its own hashtable; the tables are then merged by key into
+ * consecutive ranges. Memory grows with the number of vertices and distinct
+ * labels, not with the largest label.
+ */
+template <class G, class K>
+inline size_t compactLabelsOmpW(vector<K>& a, vector<size_t>& asiz, const G& x, const vector<K>& vcom) {
+  size_t S = x.span();
+  int    T = omp_get_max_threads();
+  auto  fp = [&](K c) { return int((uint64_t(c) * 0x9e3779b97f4a7c15ull >> 32) % uint64_t(T)); };
+  vector2d<K> bins(size_t(T)*T);
+  vector<unordered_map<K, size_t>> ids(T);
+  vector<size_t> ioff(T+1);
+  a.resize(S);
+  #pragma omp parallel
+  {
+    int t = omp_get_thread_num();
+    // Route labels of vertices to their owner threads.
+    #pragma omp for schedule(static, 2048)
+    for (K u=0; u<S; ++u)
+      if (hasVertex(x, u)) bins[size_t(t)*T + fp(vcom[u])].push_back(vcom[u]);
+    // Count the labels owned by this thread.
+    for (int s=0; s<T; ++s) {
+      for (K c : bins[size_t(s)*T + t])
+        ++ids[t][c];
+      vector<K>().swap(bins[size_t(s)*T + t]);
+    }
+    ioff[t+1] = ids[t].size();
+    #pragma omp barrier
+    #pragma omp single
+    for (int s=0; s<T; ++s)
+      ioff[s+1] += ioff[s];
+    // Give each owned label a dense id, keeping its count.
+    #pragma omp single
+    asiz.resize(ioff[T]);
+    size_t i = ioff[t];
+    for (auto& [c, n] : ids[t]) {
+      asiz[i] = n;
+      n = i++;
+    }
+    #pragma omp barrier
+    #pragma omp for schedule(static, 2048)
+    for (K u=0; u<S; ++u)
+      if (hasVertex(x, u)) a[u] = K(ids[fp(vcom[u])].find(vcom[u])->second);
+  }
+  return ioff[T];
+}
+
+
+/**
+ * Obtain the quality of a clustering, compared against a ground truth clustering.
+ * @param x given graph
+ * @param vcom community each vertex belongs to
+ * @param qcom ground truth community each vertex belongs to
+ * @returns NMI, ARI, and pair-counting precision/recall/F1
+ * @note Both labelings are first renumbered to dense ids (see
+ * compactLabelsOmpW). The contingency table is then built one community at a
+ * time, by sorting the ground truth ids of its vertices in a per-thread
+ * buffer, so memory does not grow with the number of ground truth communities
+ * per thread.
+ */
+template <class G, class K>
+inline ClusteringQuality clusteringQualityOmp(const G& x, const vector<K>& vcom, const vector<K>& qcom) {
+  size_t S = x.span();
+  int    T = omp_get_max_threads();
+  vector<K> acom, bcom;
+  vector<size_t> asiz, bsiz;
+  size_t CA = compactLabelsOmpW(acom, asiz, x, vcom);
+  size_t CB = compactLabelsOmpW(bcom, bsiz, x, qcom);
+  // Find the vertices in each community.
+  vector<size_t> coff(CA+1), bufs(T);
+  copyValuesOmpW(coff.data(), asiz.data(), CA);
+  size_t N = exclusiveScanOmpW(coff.data(), bufs.data(), coff.data(), CA);
+  coff[CA] = N;
+  vector<K> cdeg(CA), cedg(N);
+  #pragma omp parallel for schedule(static, 2048)
+  for (K u=0; u<S; ++u) {
+    if (!hasVertex(x, u)) continue;
+    csrAddEdgeOmpU(cdeg, cedg, coff, acom[u], bcom[u]);
+  }
+  // Count overlaps of each community with ground truth communities.
+  double nlnn = 0, alna = 0, blnb = 0, npairs = 0, apairs = 0, bpairs = 0, nlnab = 0;
+  #pragma omp parallel for schedule(dynamic, 2048) reduction(+:nlnn, alna, npairs, apairs, nlnab)
+  for (size_t c=0; c<CA; ++c) {
+    double a = double(cdeg[c]);
+    K *ds = cedg.data() + coff[c];
+    sort(ds, ds + cdeg[c]);
+    for (size_t i=0, I=cdeg[c]; i<I;) {
+      size_t j = i;
+      while (j<I && ds[j]==ds[i]) ++j;
+      double n = double(j-i), b = double(bsiz[ds[i]]);
+      nlnn   += n * log(n);
+      nlnab  += n * (log(a) + log(b));
+      npairs += n * (n-1) / 2;
+      i = j;
+    }
+    alna   += a * log(a);
+    apairs += a * (a-1) / 2;
+  }
+  #pragma omp parallel for schedule(static, 2048) reduction(+:blnb, bpairs)
+  for (size_t d=0; d<CB; ++d) {
+    double b = double(bsiz[d]);
+    blnb   += b * log(b);
+    bpairs += b * (b-1) / 2;
+  }
+  return clusteringQualityFrom(double(N), nlnn, alna, blnb, npairs, apairs, bpairs, nlnab);
+}
+#endif
+#pragma endregion
 #pragma endregion
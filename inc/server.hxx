@@ -0,0 +1,295 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using std::vector;
+
+
+
+
+#pragma region CONFIGURATION
+#ifndef SERVER_MAX_PAYLOAD
+/** Largest payload of a request accepted by the clustering server, in bytes. */
+#define SERVER_MAX_PAYLOAD size_t(1 << 30)
+#endif
+#ifndef SERVER_SPAN_GROWTH
+/** Largest factor by which a batch update may grow the vertex ids of a graph (at least 65536 ids are allowed). */
+#define SERVER_SPAN_GROWTH size_t(4)
+#endif
+#pragma endregion
+
+
+
+
+#pragma region TYPES
+/**
+ * Operation requested from the clustering server.
+ */
+enum ServerOperation : uint32_t {
+  /** Load a graph from a file, picking the format from its extension (payload: ServerLoad, path). */
+  SERVER_LOAD       = 1,
+  /** Run Static Louvain on a graph (payload: ServerOptions, or empty for defaults). */
+  SERVER_STATIC     = 2,
+  /** Apply a batch update, and re-cluster (payload: ServerUpdate, deletions, insertions). */
+  SERVER_UPDATE     = 3,
+  /** Obtain the community membership of each vertex (no payload). */
+  SERVER_MEMBERSHIP = 4,
+  /** Obtain summary statistics of the last clustering (no payload). */
+  SERVER_STATS      = 5,
+  /** Unload a graph (no payload). */
+  SERVER_UNLOAD     = 6,
+  /** Stop the server (no payload). */
+  SERVER_QUIT       = 7
+};
+
+
+/**
+ * Status of a response from the clustering server.
+ */
+enum ServerStatus : uint32_t {
+  /** Request was successful. */
+  SERVER_OK          = 0,
+  /** Request was malformed. */
+  SERVER_BAD_REQUEST = 1,
+  /** Graph does not exist, or is not clustered yet. */
+  SERVER_NOT_FOUND   = 2,
+  /** Graph file could not be read. */
+  SERVER_IO_ERROR    = 3
+};
+
+
+/**
+ * Approach used to re-cluster a graph after a batch update.
+ */
+enum ServerApproach : uint32_t {
+  /** Static Louvain, from scratch. */
+  SERVER_STATIC_APPROACH           = 0,
+  /** Naive-dynamic Louvain, from previous communities. */
+  SERVER_NAIVE_DYNAMIC_APPROACH    = 1,
+  /** Dynamic Frontier Louvain, from previous communities and affected vertices. */
+  SERVER_DYNAMIC_FRONTIER_APPROACH = 2
+};
+
+
+/**
+ * Header of a request to the clustering server.
+ */
+struct ServerRequest {
+  #pragma region DATA
+  /** Operation requested (ServerOperation). */
+  uint32_t operation;
+  /** Graph id to operate upon (ignored for load). */
+  uint32_t graph;
+  /** Size of payload following the header, in bytes. */
+  uint64_t size;
+  #pragma endregion
+};
+
+
+/**
+ * Header of a response from the clustering server.
+ */
+struct ServerResponse {
+  #pragma region DATA
+  /** Status of the request (ServerStatus). */
+  uint32_t status;
+  /** Graph id operated upon. */
+  uint32_t graph;
+  /** Size of payload following the header, in bytes. */
+  uint64_t size;
+  #pragma endregion
+};
+
+
+/**
+ * Payload header of a load request (followed by file path).
+ */
+struct ServerLoad {
+  #pragma region DATA
+  /** Is the graph already symmetric? */
+  uint32_t symmetric;
+  /** Is the graph weighted? */
+  uint32_t weighted;
+  #pragma endregion
+};
+
+
+/**
+ * Options for Louvain algorithm, as sent to the clustering server.
+ */
+struct ServerOptions {
+  #pragma region DATA
+  /** Number of times to repeat the algorithm. */
+  int32_t repeat;
+  /** Maximum number of iterations per pass. */
+  int32_t maxIterations;
+  /** Maximum number of passes. */
+  int32_t maxPasses;
+  /** Padding (unused). */
+  int32_t padding;
+  /** Resolution parameter for modularity. */
+  double resolution;
+  /** Tolerance for convergence. */
+  double tolerance;
+  /** Tolerance for aggregation. */
+  double aggregationTolerance;
+  /** Tolerance drop factor after each pass. */
+  double toleranceDrop;
+  #pragma endregion
+};
+
+
+/**
+ * Payload header of an update request (followed by deletions and insertions).
+ * @note Deletions are (u, v) pairs of 32-bit vertex ids, and insertions are
+ * (u, v, w) triples of 32-bit vertex ids and 32-bit float weight. Each edge is
+ * applied in both directions.
+ */
+struct ServerUpdate {
+  #pragma region DATA
+  /** Approach used to re-cluster (ServerApproach). */
+  uint32_t approach;
+  /** Padding (unused). */
+  uint32_t padding;
+  /** Number of edge deletions. */
+  uint64_t deletions;
+  /** Number of edge insertions. */
+  uint64_t insertions;
+  /** Options for Louvain algorithm. */
+  ServerOptions options;
+  #pragma endregion
+};
+
+
+/**
+ * Summary statistics of a graph and its last clustering.
+ */
+struct ServerStats {
+  #pragma region DATA
+  /** Number of vertices. */
+  uint64_t order;
+  /** Number of edges (in both directions). */
+  uint64_t size;
+  /** Largest vertex id + 1. */
+  uint64_t span;
+  /** Number of communities. */
+  uint64_t communities;
+  /** Modularity of communities. */
+  double modularity;
+  /** Time spent in milliseconds, in the last run. */
+  float time;
+  /** Time spent in milliseconds in local-moving phase, in the last run. */
+  float localMoveTime;
+  /** Time spent in milliseconds in aggregation phase, in the last run. */
+  float aggregationTime;
+  /** Number of iterations performed, in the last run. */
+  int32_t iterations;
+  /** Number of passes performed, in the last run. */
+  int32_t passes;
+  /** Number of vertices initially marked as affected, in the last run. */
+  uint64_t affectedVertices;
+  #pragma endregion
+};
+#pragma endregion
+
+
+
+
+#pragma region METHODS
+#pragma region READ/WRITE
+/**
+ * Read a given number of bytes from a socket.
+ * @param a buffer to read into (updated)
+ * @param fd socket file descriptor
+ * @param N number of bytes to read
+ * @returns success?
+ */
+inline bool readSocketW(void *a, int fd, size_t N) {
+  char *p = (char*) a;
+  while (N>0) {
+    ssize_t n = read(fd, p, N);
+    if (n<=0) return false;
+    p += n; N -= n;
+  }
+  return true;
+}
+
+
+/**
+ * Write a given number of bytes to a socket.
+ * @param fd socket file descriptor
+ * @param x buffer to write from
+ * @param N number of bytes to write
+ * @returns success?
+ * @note A peer that has gone away fails the write (EPIPE), without raising SIGPIPE.
+ */
+inline bool writeSocket(int fd, const void *x, size_t N) {
+  const char *p = (const char*) x;
+  while (N>0) {
+    ssize_t n = send(fd, p, N, MSG_NOSIGNAL);
+    if (n<=0) return false;
+    p += n; N -= n;
+  }
+  return true;
+}
+
+
+/**
+ * Write a response, with its payload, to a socket.
+ * @param fd socket file descriptor
+ * @param status status of the request
+ * @param graph graph id operated upon
+ * @param x payload
+ * @param N size of payload in bytes
+ * @returns success?
+ */
+inline bool writeServerResponse(int fd, ServerStatus status, uint32_t graph, const void *x=nullptr, size_t N=0) {
+  ServerResponse h = {status, graph, N};
+  return writeSocket(fd, &h, sizeof(h)) && (N==0 || writeSocket(fd, x, N));
+}
+#pragma endregion
+
+
+
+
+#pragma region SOCKET
+/**
+ * Listen for connections on a Unix domain socket.
+ * @param pth socket path (replaced if it exists)
+ * @param backlog maximum number of pending connections
+ * @returns socket file descriptor, or -1 on failure
+ */
+inline int listenUnixSocket(const char *pth, int backlog=16) {
+  sockaddr_un addr = {};
+  if (strlen(pth) >= sizeof(addr.sun_path)) return -1;
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, pth);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd<0) return -1;
+  unlink(pth);
+  if (bind(fd, (sockaddr*) &addr, sizeof(addr))<0 || listen(fd, backlog)<0) { close(fd); return -1; }
+  return fd;
+}
+
+
+/**
+ * Connect to a Unix domain socket.
+ * @param pth socket path
+ * @returns socket file descriptor, or -1 on failure
+ */
+inline int connectUnixSocket(const char *pth) {
+  sockaddr_un addr = {};
+  if (strlen(pth) >= sizeof(addr.sun_path)) return -1;
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, pth);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd<0) return -1;
+  if (connect(fd, (sockaddr*) &addr, sizeof(addr))<0) { close(fd); return -1; }
+  return fd;
+}
+#pragma endregion
+#pragma endregion
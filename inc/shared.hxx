@@ -0,0 +1,295 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef OPENMP
+#include <omp.h>
+#endif
+#include "_main.hxx"
+#include "Graph.hxx"
+#include "binary.hxx"
+
+using std::vector;
+
+
+
+
+#pragma region TYPES
+/** Alignment of arrays in a shared graph segment, in bytes. */
+#define SHARED_ALIGNMENT size_t(64)
+
+
+/**
+ * Header at the start of a shared graph segment.
+ * @note The magic number is written last, so a segment that is still being
+ * published is not attached to.
+ */
+struct SharedCsrHeader {
+  #pragma region DATA
+  /** Binary header (kind BINARY_SHARED_CSR). */
+  BinaryHeader binary;
+  /** Number of vertices. */
+  uint64_t order;
+  /** Number of edges. */
+  uint64_t size;
+  /** Position of offsets (size order+1), in bytes from the start. */
+  uint64_t offsetsAt;
+  /** Position of edge keys (size size), in bytes from the start. */
+  uint64_t edgeKeysAt;
+  /** Position of edge values (size size), in bytes from the start. */
+  uint64_t edgeValuesAt;
+  /** Size of the segment, in bytes. */
+  uint64_t bytes;
+  #pragma endregion
+};
+#pragma endregion
+
+
+
+
+#pragma region CLASSES
+/**
+ * Read-only CSR graph attached from a shared memory segment.
+ * @tparam K key type (vertex id)
+ * @tparam V vertex value type (vertex data)
+ * @tparam E edge value type (edge weight)
+ * @tparam O offset type
+ * @note The arrays are mapped, not copied, so many processes can cluster the
+ * same graph with a single copy in memory. The mapping is released when the
+ * graph is destroyed, or attached to another segment.
+ */
+template <class K=uint32_t, class V=None, class E=None, class O=size_t>
+class DiGraphShared : public DiGraphCsrView<K, V, E, O> {
+  #pragma region DATA
+  protected:
+  /** Offsets of an empty graph. */
+  static inline const O ZERO[1] = {};
+  /** Start of the mapping, or null if not attached. */
+  void *mapping = nullptr;
+  /** Size of the mapping, in bytes. */
+  size_t bytes = 0;
+  #pragma endregion
+
+
+  #pragma region METHODS
+  public:
+  /**
+   * Check if the graph is attached to a shared memory segment.
+   * @returns is attached?
+   */
+  inline bool attached() const noexcept {
+    return mapping!=nullptr;
+  }
+
+  /**
+   * Get the size of the mapped segment.
+   * @returns size in bytes
+   */
+  inline size_t mappedBytes() const noexcept {
+    return bytes;
+  }
+
+  /**
+   * Release the mapping, and become an empty graph.
+   */
+  inline void detach() noexcept {
+    if (mapping) munmap(mapping, bytes);
+    mapping = nullptr;
+    bytes   = 0;
+    this->N = 0;
+    this->offsets    = ZERO;
+    this->edgeKeys   = nullptr;
+    this->edgeValues = nullptr;
+  }
+
+  /**
+   * Take over a mapping of a shared graph segment.
+   * @param p start of the mapping (validated)
+   * @param B size of the mapping in bytes
+   */
+  inline void adopt(void *p, size_t B) noexcept {
+    detach();
+    const char *b = (const char*) p;
+    const SharedCsrHeader *h = (const SharedCsrHeader*) p;
+    mapping = p;
+    bytes   = B;
+    this->N = h->order;
+    this->offsets    = (const O*) (b + h->offsetsAt);
+    this->edgeKeys   = (const K*) (b + h->edgeKeysAt);
+    this->edgeValues = (const E*) (b + h->edgeValuesAt);
+  }
+  #pragma endregion
+
+
+  #pragma region CONSTRUCTORS
+  public:
+  /**
+   * Create an empty graph.
+   */
+  DiGraphShared() : DiGraphCsrView<K, V, E, O>(0, ZERO, nullptr) {}
+
+  // The mapping is owned, so the graph can be moved but not copied.
+  DiGraphShared(const DiGraphShared&) = delete;
+  DiGraphShared& operator=(const DiGraphShared&) = delete;
+  DiGraphShared(DiGraphShared&& x) : DiGraphShared() { swap(*this, x); }
+  DiGraphShared& operator=(DiGraphShared&& x) { swap(*this, x); return *this; }
+  ~DiGraphShared() { detach(); }
+  #pragma endregion
+
+
+  #pragma region FRIENDS
+  /**
+   * Swap two shared graphs.
+   * @param a first graph
+   * @param b second graph
+   */
+  friend inline void swap(DiGraphShared& a, DiGraphShared& b) noexcept {
+    using std::swap;
+    swap(static_cast<DiGraphCsrView<K, V, E, O>&>(a), static_cast<DiGraphCsrView<K, V, E, O>&>(b));
+    swap(a.mapping, b.mapping);
+    swap(a.bytes,   b.bytes);
+  }
+  #pragma endregion
+};
+#pragma endregion
+
+
+
+
+#pragma region TRAITS
+template <class K, class V, class E, class O>
+struct IsDenseGraph<DiGraphShared<K, V, E, O>> : true_type {};
+#pragma endregion
+
+
+
+
+#pragma region METHODS
+#pragma region HELPERS
+/**
+ * Round up a position to the alignment of shared graph arrays.
+ * @param i position in bytes
+ * @returns aligned position
+ */
+inline size_t sharedAlign(size_t i) noexcept {
+  return (i + SHARED_ALIGNMENT-1) / SHARED_ALIGNMENT * SHARED_ALIGNMENT;
+}
+
+
+/**
+ * Obtain the layout of a shared graph segment.
+ * @tparam K key type (vertex id)
+ * @tparam E edge value type (edge weight)
+ * @tparam O offset type
+ * @param N number of vertices
+ * @param M number of edges
+ * @returns header of the segment (magic number not set)
+ */
+template <class K, class E, class O>
+inline SharedCsrHeader sharedCsrLayout(size_t N, size_t M) noexcept {
+  SharedCsrHeader h = {};
+  h.binary       = {0, BINARY_VERSION, BINARY_SHARED_CSR, uint32_t(sizeof(K)), uint32_t(sizeof(E)), uint32_t(sizeof(O))};
+  h.order        = N;
+  h.size         = M;
+  h.offsetsAt    = sharedAlign(sizeof(SharedCsrHeader));
+  h.edgeKeysAt   = sharedAlign(h.offsetsAt  + (N+1)*sizeof(O));
+  h.edgeValuesAt = sharedAlign(h.edgeKeysAt + M*sizeof(K));
+  h.bytes        = sharedAlign(h.edgeValuesAt + M*sizeof(E));
+  return h;
+}
+#pragma endregion
+
+
+
+
+#pragma region PUBLISH
+#ifdef OPENMP
+/**
+ * Publish a graph into a named shared memory segment, in parallel.
+ * @tparam O offset type
+ * @param name segment name, e.g. "/web-graph" (see shm_open)
+ * @param x graph with dense vertex ids
+ * @returns success? (fails if the segment already exists)
+ * @note The segment outlives this process, until unlinkSharedCsr() is called.
+ */
+template <class O=size_t, class G>
+inline bool publishSharedCsrOmp(const char *name, const G& x) {
+  using K = typename G::key_type;
+  using E = typename G::edge_value_type;
+  size_t N = x.span(), M = x.size();
+  SharedCsrHeader h = sharedCsrLayout<K, E, O>(N, M);
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd<0) return false;
+  void *p = ftruncate(fd, off_t(h.bytes))==0? mmap(nullptr, h.bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (p==MAP_FAILED) { shm_unlink(name); return false; }
+  char *b = (char*) p;
+  O *offsets    = (O*) (b + h.offsetsAt);
+  K *edgeKeys   = (K*) (b + h.edgeKeysAt);
+  E *edgeValues = (E*) (b + h.edgeValuesAt);
+  vector<O> bufo(omp_get_max_threads());
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t u=0; u<N; ++u)
+    offsets[u] = O(x.degree(K(u)));
+  offsets[N] = exclusiveScanOmpW(offsets, bufo.data(), offsets, N);
+  #pragma omp parallel for schedule(dynamic, 2048)
+  for (size_t u=0; u<N; ++u) {
+    size_t i = offsets[u];
+    x.forEachEdge(K(u), [&](auto v, auto w) { edgeKeys[i] = v; edgeValues[i] = w; ++i; });
+  }
+  // Mark the segment as ready, only after its contents are written.
+  memcpy(p, &h, sizeof(h));
+  __atomic_store_n(&((SharedCsrHeader*) p)->binary.magic, BINARY_MAGIC, __ATOMIC_RELEASE);
+  munmap(p, h.bytes);
+  return true;
+}
+#endif
+
+
+/**
+ * Remove a named shared graph segment.
+ * @param name segment name
+ * @returns success?
+ * @note Processes that are attached keep their mapping until they detach.
+ */
+inline bool unlinkSharedCsr(const char *name) {
+  return shm_unlink(name)==0;
+}
+#pragma endregion
+
+
+
+
+#pragma region ATTACH
+/**
+ * Attach to a graph published in a named shared memory segment, read-only.
+ * @param a attached graph (updated)
+ * @param name segment name
+ * @returns success? (fails if the segment is missing, not yet published, or
+ * has a different version, key, weight or offset type)
+ */
+template <class K, class V, class E, class O>
+inline bool attachSharedCsrW(DiGraphShared<K, V, E, O>& a, const char *name) {
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd<0) return false;
+  struct stat st;
+  void *p = fstat(fd, &st)==0 && size_t(st.st_size) >= sizeof(SharedCsrHeader)? mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (p==MAP_FAILED) return false;
+  const SharedCsrHeader *h = (const SharedCsrHeader*) p;
+  SharedCsrHeader e = sharedCsrLayout<K, E, O>(h->order, h->size);
+  bool ok = __atomic_load_n(&h->binary.magic, __ATOMIC_ACQUIRE)==BINARY_MAGIC
+    && h->binary.version==BINARY_VERSION && h->binary.kind==BINARY_SHARED_CSR
+    && h->binary.keySize==sizeof(K) && h->binary.valueSize==sizeof(E) && h->binary.offsetSize==sizeof(O)
+    && h->offsetsAt==e.offsetsAt && h->edgeKeysAt==e.edgeKeysAt && h->edgeValuesAt==e.edgeValuesAt
+    && h->bytes==e.bytes && e.bytes <= size_t(st.st_size);
+  if (!ok) { munmap(p, st.st_size); return false; }
+  a.adopt(p, st.st_size);
+  return true;
+}
+#pragma endregion
+#pragma endregion
@@ -1,6 +1,24 @@
 #pragma once
+#include <tuple>
+#include <vector>
+#include <algorithm>
 #include "update.hxx"
 
+using std::tuple;
+using std::vector;
+using std::get;
+using std::min;
+
+
+
+
+#pragma region CONFIGURATION
+#ifndef SYMMETRICIZE_BLOCK
+/** Number of source vertices whose edges are routed to owner threads at a time. */
+#define SYMMETRICIZE_BLOCK size_t(65536)
+#endif
+#pragma endregion
+
 
 
 
@@ -31,17 +49,26 @@ inline void symmetricizeW(H& a, const G& x) {
  */
 template <class H, class G>
 inline void symmetricizeOmpW(H& a, const G& x) {
-  a.reserve(x.span());
+  using K = typename G::key_type;
+  using E = typename G::edge_value_type;
+  using X = tuple<K, K, E>;
+  size_t S = x.span();
+  vector<X> buf;
+  vector<size_t> cnts;
+  a.reserve(S);
   x.forEachVertex([&](auto u, auto d) { a.addVertex(u, d); });
-  #pragma omp parallel
-  {
-    x.forEachVertexKey([&](auto u) {
-      x.forEachEdge(u, [&](auto v, auto w) {
-        addEdgeOmpU(a, u, v, w);
-        addEdgeOmpU(a, v, u, w);
-      });
+  // Route each edge, in both directions, to the thread owning its source.
+  auto fe = [&](size_t i, auto fr) {
+    K u = K(i);
+    if (!x.hasVertex(u)) return;
+    x.forEachEdge(u, [&](auto v, auto w) {
+      fr(u, X(u, v, w));
+      fr(v, X(v, u, w));
     });
-  }
+  };
+  auto fp = [&](const X& e) { a.addEdge(get<0>(e), get<1>(e), get<2>(e)); };
+  for (size_t i=0; i<S; i+=SYMMETRICIZE_BLOCK)
+    routeOmp(buf, cnts, min(S-i, SYMMETRICIZE_BLOCK), [&](size_t j, auto fr) { fe(i+j, fr); }, fp);
   updateOmpU(a);
 }
 #endif
@@ -70,13 +97,22 @@ inline auto symmetricize(const G& x) {
  */
 template <class G>
 inline auto symmetricizeOmp(const G& x) {
+  using K = typename G::key_type;
+  using E = typename G::edge_value_type;
+  using X = tuple<K, K, E>;
+  size_t S = x.span();
+  vector<X> buf;
+  vector<size_t> cnts;
   G a = x;
-  #pragma omp parallel
-  {
-    x.forEachVertexKey([&](auto u) {
-      x.forEachEdge(u, [&](auto v, auto w) { addEdgeOmpU(a, v, u, w); });
-    });
-  }
+  // Route each reverse edge to the thread owning its source.
+  auto fe = [&](size_t i, auto fr) {
+    K u = K(i);
+    if (!x.hasVertex(u)) return;
+    x.forEachEdge(u, [&](auto v, auto w) { fr(v, X(v, u, w)); });
+  };
+  auto fp = [&](const X& e) { a.addEdge(get<0>(e), get<1>(e), get<2>(e)); };
+  for (size_t i=0; i<S; i+=SYMMETRICIZE_BLOCK)
+    routeOmp(buf, cnts, min(S-i, SYMMETRICIZE_BLOCK), [&](size_t j, auto fr) { fe(i+j, fr); }, fp);
   updateOmpU(a);
   return a;
 }
@@ -1,11 +1,15 @@
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <utility>
+#include <type_traits>
 #include <random>
 #include <iterator>
 #include <vector>
 #include <string>
 #include <iostream>
+#include <fstream>
 #include <algorithm>
 #include <omp.h>
 #include "inc/main.hxx"
@@ -28,6 +32,14 @@ using namespace std;
 /** Number of times to repeat each method. */
 #define REPEAT_METHOD 5
 #endif
+#ifndef GRAPH_ARENA
+/** Store edges of the input graph in a slab arena? */
+#define GRAPH_ARENA 0
+#endif
+#ifndef GRAPH_COMPACT
+/** Renumber vertices of the input graph to dense ids (0 runs on the loaded graph, as a baseline)? */
+#define GRAPH_COMPACT 1
+#endif
 #pragma endregion
 
 
@@ -47,6 +59,25 @@ inline double getModularity(const G& x, const LouvainResult<K>& a, double M) {
   auto fc = [&](auto u) { return a.membership[u]; };
   return modularityBy(x, fc, M, 1.0);
 }
+
+
+/**
+ * Read ground truth community membership of each vertex.
+ * @param a ground truth community of each vertex (updated)
+ * @param x original graph
+ * @param pth path to file with one community id per line, for vertices 1, 2, ...
+ * @returns success?
+ */
+template <class G, class K>
+inline bool readGroundTruthW(vector<K>& a, const G& x, const char *pth) {
+  ifstream s(pth);
+  if (!s) return false;
+  a.assign(x.span(), K());
+  size_t u = 1;
+  for (K c; u<a.size() && s >> c; ++u)
+    a[u] = c;
+  return u==a.size();
+}
 #pragma endregion
 
 
@@ -56,28 +87,94 @@ inline double getModularity(const G& x, const LouvainResult<K>& a, double M) {
 /**
  * Perform the experiment.
  * @param x original graph
+ * @param truth ground truth community of each vertex (empty if none)
  */
 template <class G>
-void runExperiment(const G& x) {
+void runExperiment(const G& x, const vector<typename G::key_type>& truth) {
   using K = typename G::key_type;
   using V = typename G::edge_value_type;
   int repeat  = REPEAT_METHOD;
   int retries = 5;
   vector<K> *init = nullptr;
-  double M = edgeWeightOmp(x)/2;
+  // Find static Louvain, which also gives the total edge weight for modularity.
+  auto   b1 = louvainStaticOmp(x, {repeat});
+  double M  = b1.totalWeight;
   // Follow a specific result logging format, which can be easily parsed later.
   auto flog = [&](const auto& ans, const char *technique) {
     printf(
       "{%03d threads} -> "
-      "{%09.1fms, %09.1fms mark, %09.1fms init, %09.1fms first, %09.1fms move, %09.1fms aggr, %04d iters, %04d passes, %01.9f modularity} %s\n",
+      "{%09.1fms, %09.1fms mark, %09.1fms init, %09.1fms first, %09.1fms move, %09.1fms aggr, %04d iters, %04d passes, %09zu skipped, %09zu sampled, %09zu rescans, %01.9f modularity} %s\n",
       MAX_THREADS,
       ans.time, ans.markingTime, ans.initializationTime, ans.firstPassTime, ans.localMoveTime, ans.aggregationTime,
-      ans.iterations, ans.passes, getModularity(x, ans, M), technique
+      ans.iterations, ans.passes, ans.skippedScans, ans.sampledScans, ans.exactRescans, getModularity(x, ans, M), technique
+    );
+    if (truth.empty()) return;
+    auto q = clusteringQualityOmp(x, ans.membership, truth);
+    printf(
+      "{%03d threads} -> {%01.9f nmi, %01.9f ari, %01.9f f1, %01.9f precision, %01.9f recall} %s\n",
+      MAX_THREADS, q.normalizedMutualInformation, q.adjustedRandIndex, q.pairF1Score, q.pairPrecision, q.pairRecall, technique
     );
   };
-  // Find static Louvain.
-  auto b1 = louvainStaticOmp(x, {repeat});
   flog(b1, "louvainStaticOmp");
+  // Find static Louvain, with asynchronous local moving.
+  auto b2 = louvainStaticOmp(x, {repeat, 1, 1e-2, 0.8, 10, 20, 10, true});
+  flog(b2, "louvainStaticOmpAsync");
+  // Find static Louvain, skipping vertices that keep staying put.
+  for (int prune=1; prune<=8; prune*=2) {
+    auto b3 = louvainStaticOmp(x, {repeat, 1, 1e-2, 0.8, 10, 20, 10, false, prune});
+    flog(b3, ("louvainStaticOmpPrune" + to_string(prune)).c_str());
+  }
+  // Find static Louvain, with high-degree vertices scanning a sample of their edges.
+  for (int sample=32; sample<=512; sample*=4) {
+    auto b4 = louvainStaticOmp(x, {repeat, 1, 1e-2, 0.8, 10, 20, 10, false, 0, sample});
+    flog(b4, ("louvainStaticOmpSample" + to_string(sample)).c_str());
+  }
+  // Find static Louvain, consuming (a copy of) the graph.
+  if constexpr (is_copy_constructible<G>::value) {
+    auto b5 = louvainStaticOmp(G(x), {repeat});
+    flog(b5, "louvainStaticOmpConsume");
+  }
+  // Find static Louvain, with threads reading a replica of the graph on their NUMA node.
+  // Replicas only help with several nodes, and are freed right after use.
+  int nodes = numaNodesOmp();
+  if (nodes > 1) {
+    DiGraphNuma<K, None, V> xr;
+    float tr = measureDuration([&]() { xr = DiGraphNuma<K, None, V>(x); });
+    printf("{%03d threads} -> {%09.1fms, %zu replicas, %09.1fMB extra} replicate\n", MAX_THREADS, tr, xr.replicas(), (xr.replicas()-1) * xr.replicaBytes() / 1e6);
+    auto b6 = louvainStaticOmp(xr, {repeat});
+    flog(b6, "louvainStaticOmpNuma");
+  }
+  // Find static Louvain, clustering each connected component separately.
+  auto b9 = louvainStaticSplitOmp(x, {repeat});
+  flog(b9, "louvainStaticOmpSplit");
+  // Find static Louvain, with options picked from graph statistics (see LOUVAIN_OVERRIDE).
+  GraphStatistics st = graphStatisticsOmp(x);
+  LouvainAutoConfig ac = louvainAutoConfigure(st, nodes);
+  ac.options.repeat = repeat;
+  if (!overrideLouvainAutoConfigW(ac, getenv("LOUVAIN_OVERRIDE"))) fprintf(stderr, "Unknown option in LOUVAIN_OVERRIDE\n");
+  printGraphStatistics(st);
+  printLouvainAutoConfig(ac);
+  if (ac.replicate) { DiGraphNuma<K, None, V> xr(x); auto b7 = louvainStaticOmp(xr, ac.options); flog(b7, "louvainStaticOmpAuto"); }
+  else              { auto b7 = louvainStaticOmp(x,  ac.options); flog(b7, "louvainStaticOmpAuto"); }
+  // Find static Louvain, reusing results cached by graph fingerprint (see LOUVAIN_CACHE).
+  uint64_t fp = 0;
+  float tf = measureDuration([&]() { fp = graphFingerprintOmp(x); });
+  printf("{%03d threads} -> {%09.1fms, %016llx fingerprint} fingerprint\n", MAX_THREADS, tf, (unsigned long long) fp);
+  // Find vertices reachable from the first vertex, with serial and parallel (direction-optimizing) BFS.
+  // The visited bitmap of the parallel BFS is allocated outside the timed region.
+  size_t ns = 0, np = 0;
+  vector<uint64_t> vis(bitmapWords(x.span()));
+  auto   ft = [](auto, auto) { return true; };
+  float  ts = measureDuration([&]() { ns = 0; bfsVisitedForEach(x, K(), ft, [&](auto, auto) { ++ns; }); });
+  float  tp = measureDuration([&]() { np = bfsVisitedForEachOmpU(vis, x, K(), ft, [](auto, auto) {}); });
+  printf("{%03d threads} -> {%09.1fms serial, %09.1fms parallel, %zu visited, %zu parallel visited} bfs\n", MAX_THREADS, ts, tp, ns, np);
+  if (const char *dir = getenv("LOUVAIN_CACHE")) {
+    for (int i=0; i<2; ++i) {
+      bool hit = false;
+      auto b8 = louvainStaticOmpCachedW(hit, x, fp, {repeat}, dir);
+      flog(b8, hit? "louvainStaticOmpCacheHit" : "louvainStaticOmpCacheMiss");
+    }
+  }
 }
 
 
@@ -94,13 +191,51 @@ int main(int argc, char **argv) {
   char *file     = argv[1];
   bool symmetric = argc>2? stoi(argv[2]) : false;
   bool weighted  = argc>3? stoi(argv[3]) : false;
+  char *tfile    = argc>4? argv[4] : nullptr;
+  char *sname    = argc>5? argv[5] : nullptr;
   omp_set_num_threads(MAX_THREADS);
   LOG("OMP_NUM_THREADS=%d\n", MAX_THREADS);
+  LOG("CPU_KERNEL_VARIANT=%s\n", cpuKernelVariant());
+  // Attach to a graph published by another process ("shm:<name>"), without copying it.
+  // Its vertex ids are already dense, and the ground truth must use them.
+  if (strncmp(file, "shm:", 4)==0) {
+    DiGraphShared<K, None, V> xs;
+    LOG("Attaching graph %s ...\n", file+4);
+    if (!attachSharedCsrW(xs, file+4)) { fprintf(stderr, "Cannot attach graph %s\n", file+4); return 1; }
+    LOG("order: %zu size: %zu [shared] {}\n", xs.order(), xs.size());
+    vector<K> truth;
+    if (tfile && !readGroundTruthW(truth, xs, tfile)) { fprintf(stderr, "Cannot read ground truth %s\n", tfile); truth.clear(); }
+    runExperiment(xs, truth);
+    printf("\n");
+    return 0;
+  }
   LOG("Loading graph %s ...\n", file);
+  #if GRAPH_ARENA
+  DiGraphArena<K, None, V> x;
+  #else
   DiGraph<K, None, V> x;
-  readMtxOmpW(x, file, weighted); LOG(""); println(x);
+  #endif
+  size_t B = 0;
+  float tl = measureDuration([&]() { B = readGraphOmpW(x, file, weighted); });
+  if (B==0) { fprintf(stderr, "Cannot read graph %s\n", file); return 1; }
+  LOG(""); println(x);
+  LOG("Read %.1f MB in %.1f ms (%.1f MB/s)\n", B/1e6, tl, B/(tl*1e3));
   if (!symmetric) { x = symmetricizeOmp(x); LOG(""); print(x); printf(" (symmetricize)\n"); }
-  runExperiment(x);
+  vector<K> truth;
+  if (tfile && !readGroundTruthW(truth, x, tfile)) { fprintf(stderr, "Cannot read ground truth %s\n", tfile); truth.clear(); }
+  #if GRAPH_COMPACT
+  // Renumber vertices to dense ids, so that kernels can skip existence checks.
+  // The compacted graph keeps the loaded graph type (DenseGraph wraps it).
+  vector<K> ks;
+  auto y = compactGraphOmp(ks, x); LOG(""); print(y); printf(" (compact)\n");
+  if (!truth.empty()) { vector<K> t(ks.size()); gatherValuesOmpW(t, truth, ks); truth = move(t); }
+  x.clear();
+  #else
+  auto& y = x;
+  #endif
+  if (sname && !publishSharedCsrOmp(sname, y)) fprintf(stderr, "Cannot publish graph %s\n", sname);
+  else if (sname) LOG("Published graph %s\n", sname);
+  runExperiment(y, truth);
   printf("\n");
   return 0;
 }
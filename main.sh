@@ -15,15 +15,29 @@ fi
 : "${TYPE:=float}"
 : "${MAX_THREADS:=64}"
 : "${REPEAT_METHOD:=5}"
+: "${GRAPH_ARENA:=0}"
+: "${GRAPH_COMPACT:=1}"
+: "${GRAPH_GZIP:=1}"
+: "${GRAPH_ZSTD:=0}"
 # Define macros (dont forget to add here)
 DEFINES=(""
 "-DTYPE=$TYPE"
 "-DMAX_THREADS=$MAX_THREADS"
 "-DREPEAT_METHOD=$REPEAT_METHOD"
+"-DGRAPH_ARENA=$GRAPH_ARENA"
+"-DGRAPH_COMPACT=$GRAPH_COMPACT"
+"-DGRAPH_GZIP=$GRAPH_GZIP"
+"-DGRAPH_ZSTD=$GRAPH_ZSTD"
 )
+# Leave CPU_MULTIVERSION unset to let inc/_cpu.hxx pick it for the compiler/target
+if [[ -n "$CPU_MULTIVERSION" ]]; then DEFINES+=("-DCPU_MULTIVERSION=$CPU_MULTIVERSION"); fi
+# Link libraries (for compressed graphs)
+LIBS=("")
+if [[ "$GRAPH_GZIP" == "1" ]]; then LIBS+=("-lz");    fi
+if [[ "$GRAPH_ZSTD" == "1" ]]; then LIBS+=("-lzstd"); fi
 
 # Run
-g++ ${DEFINES[*]} -std=c++17 -O3 -fopenmp main.cxx
+g++ ${DEFINES[*]} -std=c++17 -O3 -fopenmp main.cxx ${LIBS[*]}
 # stdbuf --output=L ./a.out ~/Data/web-Stanford.mtx   0 0 2>&1 | tee -a "$out"
 stdbuf --output=L ./a.out ~/Data/indochina-2004.mtx  0 0 2>&1 | tee -a "$out"
 stdbuf --output=L ./a.out ~/Data/uk-2002.mtx         0 0 2>&1 | tee -a "$out"
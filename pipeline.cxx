@@ -0,0 +1,246 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <future>
+#include <algorithm>
+#include <omp.h>
+#include "inc/main.hxx"
+
+using namespace std;
+
+
+
+
+#pragma region CONFIGURATION
+#ifndef TYPE
+/** Type of edge weights. */
+#define TYPE float
+#endif
+#ifndef MAX_THREADS
+/** Maximum number of threads to use. */
+#define MAX_THREADS 64
+#endif
+#ifndef LOADER_THREADS
+/** Number of threads reserved for loading the next graph. */
+#define LOADER_THREADS max(MAX_THREADS/8, 1)
+#endif
+#pragma endregion
+
+
+
+
+#pragma region TYPES
+/** Key type (vertex-id). */
+using K = uint32_t;
+/** Edge weight type. */
+using V = TYPE;
+
+
+/**
+ * A graph to cluster, as listed in a manifest.
+ */
+struct PipelineJob {
+  #pragma region DATA
+  /** Path to graph file. */
+  string path;
+  /** Is the graph already symmetric? */
+  bool symmetric = false;
+  /** Is the graph weighted? */
+  bool weighted  = false;
+  /** Options for Louvain algorithm. */
+  LouvainOptions options;
+  /** Pick options from graph statistics (see louvainAutoConfigure)? */
+  bool automatic = false;
+  /** Options given explicitly, which override the picked ones. */
+  string overrides;
+  #pragma endregion
+};
+
+
+/**
+ * A graph loaded for clustering.
+ */
+struct PipelineGraph {
+  #pragma region DATA
+  /** Symmetric graph with dense vertex ids. */
+  DenseGraph<DiGraph<K, None, V>> graph;
+  /** Number of bytes read from the graph file. */
+  size_t bytes = 0;
+  /** Time spent in milliseconds loading the graph. */
+  float loadTime = 0;
+  /** Was the graph read? */
+  bool loaded = false;
+  #pragma endregion
+};
+#pragma endregion
+
+
+
+
+#pragma region METHODS
+#pragma region READ MANIFEST
+/**
+ * Read an option of a manifest entry, as key=value.
+ * @param a graph to cluster (updated)
+ * @param kv option as key=value (see readLouvainOptionW), or auto=1
+ * @returns is the option known?
+ */
+inline bool readPipelineOptionW(PipelineJob& a, const string& kv) {
+  if (kv=="auto=1" || kv=="auto=0") { a.automatic = kv=="auto=1"; return true; }
+  if (!readLouvainOptionW(a.options, kv)) return false;
+  a.overrides += kv + " ";
+  return true;
+}
+
+
+/**
+ * Read a manifest of graphs to cluster.
+ * @param a graphs to cluster (updated)
+ * @param pth path to manifest, with one graph per line as
+ * "<graph path> <symmetric> <weighted> [key=value ...]"
+ * @returns success?
+ * @note With auto=1, options are picked from the statistics of each graph, and
+ * the options given override them.
+ * @note Empty lines, and lines starting with '#', are ignored.
+ */
+inline bool readPipelineManifestW(vector<PipelineJob>& a, const char *pth) {
+  ifstream s(pth);
+  if (!s) return false;
+  string line;
+  a.clear();
+  for (size_t l=1; getline(s, line); ++l) {
+    istringstream ls(line);
+    PipelineJob j; string kv;
+    if (!(ls >> j.path) || j.path[0]=='#') continue;
+    if (!(ls >> j.symmetric >> j.weighted)) { fprintf(stderr, "%s:%zu: expected <path> <symmetric> <weighted>\n", pth, l); return false; }
+    while (ls >> kv)
+      if (!readPipelineOptionW(j, kv)) { fprintf(stderr, "%s:%zu: unknown option %s\n", pth, l, kv.c_str()); return false; }
+    a.push_back(move(j));
+  }
+  return true;
+}
+#pragma endregion
+
+
+
+
+#pragma region LOAD
+/**
+ * Load, symmetricize, and compact a graph (see readGraphOmpW for formats).
+ * @param j graph to load
+ * @param T number of threads to use
+ * @returns loaded graph
+ * @note This runs on its own thread, with its own OpenMP thread team.
+ */
+inline PipelineGraph pipelineLoad(const PipelineJob& j, int T) {
+  PipelineGraph a;
+  omp_set_num_threads(T);
+  a.loadTime = measureDuration([&]() {
+    DiGraph<K, None, V> x;
+    if (!ifstream(j.path)) return;
+    a.bytes  = readGraphOmpW(x, j.path.c_str(), j.weighted);
+    a.loaded = a.bytes > 0;
+    if (!a.loaded) return;
+    if (!j.symmetric) x = symmetricizeOmp(x);
+    vector<K> ks;
+    a.graph  = compactGraphOmp(ks, x);
+  });
+  return a;
+}
+#pragma endregion
+
+
+
+
+#pragma region PERFORM EXPERIMENT
+/**
+ * Cluster a loaded graph, and write its results.
+ * @param j graph to cluster
+ * @param b loaded graph
+ * @param wait time spent in milliseconds waiting for the graph to load
+ * @returns time spent in milliseconds clustering
+ */
+inline float pipelineCluster(const PipelineJob& j, const PipelineGraph& b, float wait) {
+  const auto& x = b.graph;
+  // Follow the log format of main.cxx, so that process.js can parse it.
+  LOG("Loading graph %s ...\n", j.path.c_str());
+  if (!b.loaded) { fprintf(stderr, "Cannot read graph %s\n", j.path.c_str()); return 0; }
+  LOG("order: %zu size: %zu [directed] {}\n", x.order(), x.size());
+  double M  = edgeWeightOmp(x)/2;
+  LouvainAutoConfig ac;
+  ac.options = j.options;
+  if (j.automatic) {
+    GraphStatistics st = graphStatisticsOmp(x);
+    ac = louvainAutoConfigure(st, numaNodesOmp());
+    overrideLouvainAutoConfigW(ac, j.overrides.c_str());
+    printGraphStatistics(st);
+    printLouvainAutoConfig(ac);
+  }
+  // Reuse results of identical graph and options, if a cache directory is given.
+  const char *dir = getenv("LOUVAIN_CACHE");
+  uint64_t fp = 0; bool hit = false;
+  float tf = dir? measureDuration([&]() { fp = graphFingerprintOmp(x); }) : 0;
+  auto fl  = [&](const auto& y) { return dir? louvainStaticOmpCachedW(hit, y, fp, ac.options, dir) : louvainStaticOmp(y, ac.options); };
+  auto ans = [&]() {
+    if (!ac.replicate) return fl(x);
+    DiGraphNuma<K, None, V> xr(x);
+    return fl(xr);
+  }();
+  auto   fc = [&](auto u) { return ans.membership[u]; };
+  printf(
+    "{%03d threads} -> "
+    "{%09.1fms, %09.1fms mark, %09.1fms init, %09.1fms first, %09.1fms move, %09.1fms aggr, %04d iters, %04d passes, %09zu skipped, %09zu sampled, %09zu rescans, %01.9f modularity} %s\n",
+    omp_get_max_threads(),
+    ans.time, ans.markingTime, ans.initializationTime, ans.firstPassTime, ans.localMoveTime, ans.aggregationTime,
+    ans.iterations, ans.passes, ans.skippedScans, ans.sampledScans, ans.exactRescans, modularityByOmp(x, fc, M, 1.0), j.automatic? "louvainStaticOmpAuto" : "louvainStaticOmp"
+  );
+  if (dir) printf("{%09.1fms fingerprint, %016llx fingerprint, %s} cache\n", tf, (unsigned long long) fp, hit? "hit" : "miss");
+  printf("{%09.1fms load, %09.1fMB/s read, %09.1fms wait} pipeline\n", b.loadTime, b.bytes/(b.loadTime*1e3), wait);
+  fflush(stdout);
+  return ans.time;
+}
+
+
+/**
+ * Main function.
+ * @param argc argument count
+ * @param argv argument values
+ * @returns zero on success, non-zero on failure
+ */
+int main(int argc, char **argv) {
+  install_sigsegv();
+  if (argc<2) { fprintf(stderr, "Usage: %s <manifest>\n", argv[0]); return 1; }
+  vector<PipelineJob> jobs;
+  if (!readPipelineManifestW(jobs, argv[1])) { fprintf(stderr, "Cannot read manifest %s\n", argv[1]); return 1; }
+  if (jobs.empty()) { fprintf(stderr, "No graphs in manifest %s\n", argv[1]); return 1; }
+  // Clustering threads share the machine with the threads loading the next graph.
+  int L = min(LOADER_THREADS, MAX_THREADS);
+  int T = max(MAX_THREADS - L, 1);
+  omp_set_num_threads(T);
+  LOG("OMP_NUM_THREADS=%d\n", T);
+  LOG("LOADER_THREADS=%d\n", L);
+  LOG("CPU_KERNEL_VARIANT=%s\n", cpuKernelVariant());
+  size_t N = jobs.size();
+  float tc = 0, tl = 0, tw = 0;
+  float tt = measureDuration([&]() {
+    // The first graph has nothing to overlap with, so it is loaded with all threads.
+    future<PipelineGraph> next = async(launch::async, pipelineLoad, cref(jobs[0]), MAX_THREADS);
+    for (size_t i=0; i<N; ++i) {
+      PipelineGraph b;
+      float w = measureDuration([&]() { b = next.get(); });
+      if (i+1<N) next = async(launch::async, pipelineLoad, cref(jobs[i+1]), L);
+      tc += pipelineCluster(jobs[i], b, w);
+      tl += b.loadTime;
+      tw += w;
+    }
+  });
+  printf("{%09.1fms total, %09.1fms cluster, %09.1fms load, %09.1fms wait, %zu graphs} pipeline\n", tt, tc, tl, tw, N);
+  return 0;
+}
+#pragma endregion
+#pragma endregion
@@ -3,9 +3,9 @@ const os = require('os');
 const path = require('path');
 
 const ROMPTH = /^OMP_NUM_THREADS=(\d+)/;
-const RGRAPH = /^Loading graph .*\/(.*?)\.mtx \.\.\./m;
+const RGRAPH = /^Loading graph .*\/(.*?)\.\w+ \.\.\./m;
 const RORDER = /^order: (\d+) size: (\d+) (?:\[\w+\] )?\{\}/m;
-const RRESLT = /^\{(.+?) threads\} -> \{(.+?)ms, (.+?)ms mark, (.+?) init, (.+?)ms first, (.+?)ms move, (.+?)ms aggr, (.+?) iters, (.+?) passes, (.+?) modularity\} (.+)/m;
+const RRESLT = /^\{(.+?) threads\} -> \{(.+?)ms, (.+?)ms mark, (.+?) init, (.+?)ms first, (.+?)ms move, (.+?)ms aggr, (.+?) iters, (.+?) passes, (?:(.+?) skipped, )?(?:(.+?) sampled, (.+?) rescans, )?(.+?) modularity\} (.+)/m;
 
 
 
@@ -60,7 +60,7 @@ function readLogLine(ln, data, state) {
     state.size  = parseFloat(size);
   }
   else if (RRESLT.test(ln)) {
-    var [, num_threads, time, marking_time, initialization_time, first_pass_time, local_moving_phase_time, aggregation_phase_time, iterations, passes, modularity, technique] = RRESLT.exec(ln);
+    var [, num_threads, time, marking_time, initialization_time, first_pass_time, local_moving_phase_time, aggregation_phase_time, iterations, passes, skipped_scans, sampled_scans, exact_rescans, modularity, technique] = RRESLT.exec(ln);
     data.get(state.graph).push(Object.assign({}, state, {
       num_threads:  parseFloat(num_threads),
       time:         parseFloat(time),
@@ -71,6 +71,9 @@ function readLogLine(ln, data, state) {
       aggregation_phase_time:  parseFloat(aggregation_phase_time),
       iterations:  parseFloat(iterations),
       passes:      parseFloat(passes),
+      skipped_scans: parseFloat(skipped_scans || '0'),
+      sampled_scans: parseFloat(sampled_scans || '0'),
+      exact_rescans: parseFloat(exact_rescans || '0'),
       modularity:  parseFloat(modularity),
       technique,
     }));
@@ -0,0 +1,335 @@
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <utility>
+#include <memory>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <tuple>
+#include <algorithm>
+#include <omp.h>
+#include "inc/main.hxx"
+#include "inc/server.hxx"
+
+using namespace std;
+
+
+
+
+#pragma region CONFIGURATION
+#ifndef TYPE
+/** Type of edge weights. */
+#define TYPE float
+#endif
+#ifndef MAX_THREADS
+/** Maximum number of threads to use. */
+#define MAX_THREADS 64
+#endif
+#pragma endregion
+
+
+
+
+#pragma region TYPES
+/** Key type (vertex-id). */
+using K = uint32_t;
+/** Edge weight type. */
+using V = TYPE;
+/** Hashtable weight type. */
+using W = LOUVAIN_WEIGHT_TYPE;
+
+
+/**
+ * A graph resident in the server, with its last clustering.
+ * @note Only the state a dynamic run is seeded from is kept between requests.
+ * The scratch buffers of Louvain algorithm (hashtables, CSRs of communities)
+ * are allocated by each run, as louvainInvokeOmp() owns them.
+ */
+struct ServerGraph {
+  #pragma region DATA
+  /** Symmetric graph. */
+  DiGraph<K, None, V> graph;
+  /** Community membership of each vertex, from the last run. */
+  vector<K> membership;
+  /** Total edge weight of each vertex, from the last run. */
+  vector<W> vertexWeight;
+  /** Total edge weight of each community, from the last run. */
+  vector<W> communityWeight;
+  /** Aggregated graph of the last dynamic run, reused by the next one. */
+  LouvainHierarchy<K, W> hierarchy;
+  /** Summary statistics of the last run. */
+  ServerStats stats = {};
+  #pragma endregion
+};
+#pragma endregion
+
+
+
+
+#pragma region METHODS
+#pragma region HELPERS
+/**
+ * Convert options sent to the server into Louvain options.
+ * @param x options sent to the server
+ * @returns louvain options
+ */
+inline LouvainOptions serverLouvainOptions(const ServerOptions& x) {
+  LouvainOptions o;
+  if (x.repeat>0)        o.repeat        = x.repeat;
+  if (x.maxIterations>0) o.maxIterations = x.maxIterations;
+  if (x.maxPasses>0)     o.maxPasses     = x.maxPasses;
+  if (x.resolution>0)    o.resolution    = x.resolution;
+  if (x.tolerance>0)     o.tolerance     = x.tolerance;
+  if (x.aggregationTolerance>0) o.aggregationTolerance = x.aggregationTolerance;
+  if (x.toleranceDrop>0) o.toleranceDrop = x.toleranceDrop;
+  return o;
+}
+
+
+/**
+ * Update summary statistics of a graph.
+ * @param a graph resident in the server (updated)
+ */
+inline void serverUpdateStats(ServerGraph& a) {
+  const auto& x = a.graph;
+  a.stats.order = x.order();
+  a.stats.size  = x.size();
+  a.stats.span  = x.span();
+  if (a.membership.empty()) return;
+  auto   fc = [&](auto u) { return a.membership[u]; };
+  double M  = edgeWeightOmp(x)/2;
+  auto coms = communitySizeOmp(x, a.membership);
+  a.stats.communities = coms.size() - countValueOmp(coms, K());
+  a.stats.modularity  = modularityByOmp(x, fc, M, 1.0);
+}
+
+
+/**
+ * Store the result of a run in a graph.
+ * @param a graph resident in the server (updated)
+ * @param b louvain result (moved)
+ */
+template <class R>
+inline void serverStoreResult(ServerGraph& a, R&& b) {
+  a.stats.time             = b.time;
+  a.stats.localMoveTime    = b.localMoveTime;
+  a.stats.aggregationTime  = b.aggregationTime;
+  a.stats.iterations       = b.iterations;
+  a.stats.passes           = b.passes;
+  a.stats.affectedVertices = b.affectedVertices;
+  a.membership      = move(b.membership);
+  a.vertexWeight    = move(b.vertexWeight);
+  a.communityWeight = move(b.communityWeight);
+  serverUpdateStats(a);
+}
+
+
+/**
+ * Read a batch update from a payload, in both directions.
+ * @param deletions edge deletions, without weights (updated)
+ * @param insertions edge insertions (updated)
+ * @param h update request header
+ * @param buf payload after the header
+ * @param N size of payload after the header, in bytes
+ * @param S span of the graph (vertex ids may grow to SERVER_SPAN_GROWTH times it)
+ * @returns success?
+ */
+inline bool serverReadBatch(vector<tuple<K, K, V>>& deletions, vector<tuple<K, K, V>>& insertions, const ServerUpdate& h, const char *buf, size_t N, size_t S) {
+  size_t DS = 2*sizeof(K), IS = 2*sizeof(K) + sizeof(float);
+  // Check counts before multiplying, so that huge counts cannot wrap around.
+  if (h.deletions > N/DS) return false;
+  if (h.insertions > (N - h.deletions*DS)/IS) return false;
+  if (h.deletions*DS + h.insertions*IS != N) return false;
+  // A single large id would make the graph allocate space for all ids below it.
+  size_t L = min(SERVER_SPAN_GROWTH * max(S, size_t(1) << 16), size_t(numeric_limits<K>::max()));
+  deletions.clear();
+  insertions.clear();
+  for (size_t i=0; i<h.deletions; ++i, buf+=DS) {
+    K u, v;
+    memcpy(&u, buf, sizeof(K));
+    memcpy(&v, buf+sizeof(K), sizeof(K));
+    if (u>=L || v>=L) return false;
+    deletions.push_back({u, v, V()});
+    if (u!=v) deletions.push_back({v, u, V()});
+  }
+  for (size_t i=0; i<h.insertions; ++i, buf+=IS) {
+    K u, v; float w;
+    memcpy(&u, buf, sizeof(K));
+    memcpy(&v, buf+sizeof(K), sizeof(K));
+    memcpy(&w, buf+2*sizeof(K), sizeof(float));
+    if (u>=L || v>=L) return false;
+    insertions.push_back({u, v, V(w)});
+    if (u!=v) insertions.push_back({v, u, V(w)});
+  }
+  return true;
+}
+#pragma endregion
+
+
+
+
+#pragma region HANDLE REQUESTS
+/**
+ * Load a graph from a file (MTX, METIS, SNAP or binary edge list, optionally compressed).
+ * @param gs graphs resident in the server (updated)
+ * @param fd client socket
+ * @param buf payload
+ * @returns success?
+ */
+inline bool serverLoad(vector<unique_ptr<ServerGraph>>& gs, int fd, const vector<char>& buf) {
+  if (buf.size() <= sizeof(ServerLoad)) return writeServerResponse(fd, SERVER_BAD_REQUEST, 0);
+  ServerLoad h;
+  memcpy(&h, buf.data(), sizeof(h));
+  string pth(buf.data() + sizeof(h), buf.size() - sizeof(h));
+  auto a = make_unique<ServerGraph>();
+  LOG("Loading graph %s ...\n", pth.c_str());
+  if (!readGraphOmpW(a->graph, pth.c_str(), h.weighted)) {
+    LOG("Cannot read graph %s\n", pth.c_str());
+    return writeServerResponse(fd, SERVER_IO_ERROR, 0);
+  }
+  if (!h.symmetric) a->graph = symmetricizeOmp(a->graph);
+  LOG(""); println(a->graph);
+  serverUpdateStats(*a);
+  uint32_t g = gs.size();
+  gs.push_back(move(a));
+  return writeServerResponse(fd, SERVER_OK, g, &gs[g]->stats, sizeof(ServerStats));
+}
+
+
+/**
+ * Run Static Louvain on a graph, keeping the ids of previous communities where it can.
+ * @param a graph resident in the server (updated)
+ * @param fd client socket
+ * @param g graph id
+ * @param buf payload
+ * @returns success?
+ */
+inline bool serverStatic(ServerGraph& a, int fd, uint32_t g, const vector<char>& buf) {
+  ServerOptions h = {};
+  if (!buf.empty() && buf.size()!=sizeof(h)) return writeServerResponse(fd, SERVER_BAD_REQUEST, g);
+  if (!buf.empty()) memcpy(&h, buf.data(), sizeof(h));
+  a.hierarchy = {};
+  auto b = louvainStaticOmp(a.graph, serverLouvainOptions(h));
+  if (!a.membership.empty()) louvainStabilizeResultOmpU(b, a.graph, a.membership);
+  serverStoreResult(a, move(b));
+  return writeServerResponse(fd, SERVER_OK, g, &a.stats, sizeof(ServerStats));
+}
+
+
+/**
+ * Apply a batch update to a graph, and re-cluster it.
+ * @param a graph resident in the server (updated)
+ * @param fd client socket
+ * @param g graph id
+ * @param buf payload
+ * @returns success?
+ */
+inline bool serverUpdate(ServerGraph& a, int fd, uint32_t g, const vector<char>& buf) {
+  ServerUpdate h;
+  vector<tuple<K, K, V>> deletions, insertions;
+  if (buf.size() < sizeof(h)) return writeServerResponse(fd, SERVER_BAD_REQUEST, g);
+  memcpy(&h, buf.data(), sizeof(h));
+  if (!serverReadBatch(deletions, insertions, h, buf.data() + sizeof(h), buf.size() - sizeof(h), a.graph.span())) return writeServerResponse(fd, SERVER_BAD_REQUEST, g);
+  auto& x = a.graph;
+  auto  o = serverLouvainOptions(h.options);
+  tidyBatchUpdateU(deletions, insertions, x);
+  // Dynamic runs subtract the weight of each deleted edge, so it is taken from the graph.
+  #pragma omp parallel for schedule(static, 2048)
+  for (size_t i=0; i<deletions.size(); ++i)
+    get<2>(deletions[i]) = x.edgeValue(get<0>(deletions[i]), get<1>(deletions[i]));
+  applyBatchUpdateOmpU(x, deletions, insertions);
+  // New vertices start in their own (unused) community.
+  size_t S = x.span(), Q = a.membership.size();
+  bool dynamic = h.approach!=SERVER_STATIC_APPROACH && Q>0;
+  if (dynamic) {
+    a.membership.resize(S);
+    a.vertexWeight.resize(S);
+    a.communityWeight.resize(S);
+    for (size_t u=Q; u<S; ++u)
+      a.membership[u] = K(u);
+  }
+  // The kept aggregated graph misses batches not seen by a dynamic run.
+  if (!dynamic) a.hierarchy = {};
+  if (!dynamic) {
+    auto b = louvainStaticOmp(x, o);
+    if (Q>0) louvainStabilizeResultOmpU(b, x, a.membership);
+    serverStoreResult(a, move(b));
+  }
+  else if (h.approach==SERVER_NAIVE_DYNAMIC_APPROACH) serverStoreResult(a, louvainNaiveDynamicOmp(x, deletions, insertions, a.membership, a.vertexWeight, a.communityWeight, o, &a.hierarchy));
+  else serverStoreResult(a, louvainDynamicFrontierOmp(x, deletions, insertions, a.membership, a.vertexWeight, a.communityWeight, o, &a.hierarchy));
+  return writeServerResponse(fd, SERVER_OK, g, &a.stats, sizeof(ServerStats));
+}
+
+
+/**
+ * Serve requests from a client, until it disconnects or asks the server to stop.
+ * @param gs graphs resident in the server (updated)
+ * @param fd client socket
+ * @returns should the server keep running?
+ */
+inline bool serveClient(vector<unique_ptr<ServerGraph>>& gs, int fd) {
+  ServerRequest h;
+  vector<char>  buf;
+  while (readSocketW(&h, fd, sizeof(h))) {
+    // The rest of an oversized request cannot be skipped reliably, so the client is dropped.
+    if (h.size > SERVER_MAX_PAYLOAD) { writeServerResponse(fd, SERVER_BAD_REQUEST, h.graph); break; }
+    buf.resize(h.size);
+    if (!readSocketW(buf.data(), fd, h.size)) break;
+    bool found = h.graph < gs.size() && gs[h.graph];
+    bool ok    = true;
+    switch (h.operation) {
+      case SERVER_LOAD: ok = serverLoad(gs, fd, buf); break;
+      case SERVER_QUIT: writeServerResponse(fd, SERVER_OK, h.graph); return false;
+      case SERVER_STATIC:
+      case SERVER_UPDATE:
+      case SERVER_MEMBERSHIP:
+      case SERVER_STATS:
+      case SERVER_UNLOAD:
+        if (!found) { ok = writeServerResponse(fd, SERVER_NOT_FOUND, h.graph); break; }
+        if (h.operation==SERVER_STATIC) ok = serverStatic(*gs[h.graph], fd, h.graph, buf);
+        if (h.operation==SERVER_UPDATE) ok = serverUpdate(*gs[h.graph], fd, h.graph, buf);
+        if (h.operation==SERVER_STATS)  ok = writeServerResponse(fd, SERVER_OK, h.graph, &gs[h.graph]->stats, sizeof(ServerStats));
+        if (h.operation==SERVER_UNLOAD) { gs[h.graph].reset(); ok = writeServerResponse(fd, SERVER_OK, h.graph); }
+        if (h.operation==SERVER_MEMBERSHIP) {
+          const auto& q = gs[h.graph]->membership;
+          if (q.empty()) ok = writeServerResponse(fd, SERVER_NOT_FOUND, h.graph);
+          else ok = writeServerResponse(fd, SERVER_OK, h.graph, q.data(), q.size() * sizeof(K));
+        }
+        break;
+      default: ok = writeServerResponse(fd, SERVER_BAD_REQUEST, h.graph); break;
+    }
+    if (!ok) break;
+  }
+  return true;
+}
+
+
+/**
+ * Main function.
+ * @param argc argument count
+ * @param argv argument values
+ * @returns zero on success, non-zero on failure
+ */
+int main(int argc, char **argv) {
+  install_sigsegv();
+  const char *pth = argc>1? argv[1] : "/tmp/louvain.sock";
+  omp_set_num_threads(MAX_THREADS);
+  LOG("OMP_NUM_THREADS=%d\n", MAX_THREADS);
+  LOG("CPU_KERNEL_VARIANT=%s\n", cpuKernelVariant());
+  int sfd = listenUnixSocket(pth);
+  if (sfd<0) { fprintf(stderr, "Cannot listen on %s\n", pth); return 1; }
+  LOG("Listening on %s ...\n", pth);
+  vector<unique_ptr<ServerGraph>> gs;
+  for (bool run=true; run;) {
+    int fd = accept(sfd, nullptr, nullptr);
+    if (fd<0) continue;
+    run = serveClient(gs, fd);
+    close(fd);
+  }
+  close(sfd);
+  unlink(pth);
+  return 0;
+}
+#pragma endregion
+#pragma endregion